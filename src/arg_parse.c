@@ -29,12 +29,18 @@
 // Posix includes.
 #include <sys/stat.h>
 
+// Third party includes.
+#include <SimpleArchiver/src/helpers.h>
+
 // Local includes.
 #include "constants.h"
 
 void print_usage(void) {
   puts("Usage:");
   puts("  -p <port> | --port <port>");
+  puts("  --listen=<ADDR> (can be used multiple times)");
+  puts("    Listen on unix:<path>, <IPv4>[:<port>], or [<IPv6>][:<port>]");
+  puts("    instead of all addresses on --port");
   puts("  --config=<config_file>");
   puts("  --disable-peer-addr-print");
   puts("  --req-header-to-print=<header> (can be used multiple times)");
@@ -47,6 +53,52 @@ void print_usage(void) {
   puts("  --generate-dir=<DIR>");
   puts("  --generate-enable-overwrite");
   puts("  --generate-static-enable-overwrite");
+  puts("  --keep-alive-timeout-seconds=<SECONDS>");
+  puts("  --header-timeout-seconds=<SECONDS>");
+  puts("    Close connections not sending a request's headers within SECONDS");
+  puts("    (default 3)");
+  puts("  --idle-timeout-seconds=<SECONDS>");
+  puts("    Close connections not taking a response for SECONDS (default 5)");
+  puts("  --min-recv-rate=<BYTES_PER_SECOND>");
+  puts("    Close connections sending a request's headers slower than this");
+  puts("  --keep-alive-max-requests=<N>");
+  puts("    Set to 1 to disable keep-alive");
+  puts("  --drain-timeout-seconds=<SECONDS>");
+  puts("    On SIGTERM/SIGINT, stop accepting and wait up to SECONDS for open");
+  puts("    connections to finish before exiting (default 10)");
+  puts("  --workers=<N>");
+  puts("    Handle connections with N threads (default 1)");
+  puts("  --worker-cpus=<CPUS>[,<CPUS>...]");
+  puts("    Pin each worker to a CPU or a range of CPUs (like 2-3), in order");
+  puts("  --reuseport-cpu-bpf");
+  puts("    Pass connections to the worker on the CPU that received them");
+  puts("  --max-connections=<N>");
+  puts("    Preallocate and limit to N connections (default 1024)");
+  puts("  --accept-budget=<N>");
+  puts("    Accept at most N connections before serving others (default 64)");
+  puts("  --overload-connections=<N>");
+  puts("    Stop accepting while there are N or more connections");
+  puts("  --overload-queued-bytes=<BYTES>");
+  puts("    Stop accepting while BYTES or more are waiting to be sent");
+  puts("  --overload-reject");
+  puts("    When overloaded, accept and reply with 503 instead");
+  puts("  --rate-limit=<N>");
+  puts("    Reply with 429 to clients (IPv4 address or IPv6 /64) making more");
+  puts("    than N requests per second");
+  puts("  --rate-limit-burst=<N>");
+  puts("    Requests a client may make at once (default the --rate-limit)");
+  puts("  --listen-backlog=<N>");
+  puts("    Max pending connections to accept (default 64)");
+  puts("  --tcp-defer-accept=<SECONDS>");
+  puts("    Only accept connections once they sent data (TCP_DEFER_ACCEPT)");
+  puts("  --tcp-fastopen=<N>");
+  puts("    Enable TCP Fast Open with a queue of N pending connections");
+  puts("  --enable-reuse-addr");
+  puts("    Set SO_REUSEADDR on the listening socket");
+  puts("  --enable-io-uring");
+  puts("    Use io_uring instead of epoll (requires Linux 6.0 or newer)");
+  puts("    Accepts are multishot only with --disable-peer-addr-print and");
+  puts("    without --rate-limit, as peer addresses are otherwise needed");
 }
 
 Args parse_args(int32_t argc, char **argv) {
@@ -57,7 +109,18 @@ Args parse_args(int32_t argc, char **argv) {
   Args args;
   memset(&args, 0, sizeof(Args));
   args.list_of_headers_to_log = simple_archiver_list_init();
+  args.listen_addrs = simple_archiver_list_init();
   args.cache_lifespan_seconds = C_SIMPLE_HTTP_DEFAULT_CACHE_LIFESPAN_SECONDS;
+  args.workers = 1;
+  args.max_connections = C_SIMPLE_HTTP_DEFAULT_MAX_CONNECTIONS;
+  args.accept_budget = C_SIMPLE_HTTP_DEFAULT_ACCEPT_BUDGET;
+  args.listen_backlog = C_SIMPLE_HTTP_DEFAULT_LISTEN_BACKLOG;
+  args.keep_alive_timeout_seconds =
+    C_SIMPLE_HTTP_DEFAULT_KEEP_ALIVE_TIMEOUT_SECONDS;
+  args.keep_alive_max_requests = C_SIMPLE_HTTP_DEFAULT_KEEP_ALIVE_MAX_REQUESTS;
+  args.header_timeout_seconds = C_SIMPLE_HTTP_DEFAULT_HEADER_TIMEOUT_SECONDS;
+  args.idle_timeout_seconds = C_SIMPLE_HTTP_DEFAULT_IDLE_TIMEOUT_SECONDS;
+  args.drain_timeout_seconds = C_SIMPLE_HTTP_DEFAULT_DRAIN_TIMEOUT_SECONDS;
 
   while (argc > 0) {
     if ((strcmp(argv[0], "-p") == 0 || strcmp(argv[0], "--port") == 0)
@@ -68,6 +131,16 @@ Args parse_args(int32_t argc, char **argv) {
       }
       --argc;
       ++argv;
+    } else if (strncmp(argv[0], "--listen=", 9) == 0
+        && strlen(argv[0]) > 9) {
+      if (simple_archiver_list_add(
+            args.listen_addrs,
+            argv[0] + 9,
+            simple_archiver_helper_datastructure_cleanup_nop)
+          != 0) {
+        fprintf(stderr, "ERROR Failed to parse \"--listen=...\" !\n");
+        exit(1);
+      }
     } else if (strncmp(argv[0], "--config=", 9) == 0 && strlen(argv[0]) > 9) {
       args.config_file = argv[0] + 9;
     } else if (strcmp(argv[0], "--disable-peer-addr-print") == 0) {
@@ -192,6 +265,192 @@ Args parse_args(int32_t argc, char **argv) {
       args.flags |= 4;
     } else if (strcmp(argv[0], "--generate-static-enable-overwrite") == 0) {
       args.flags |= 8;
+    } else if (strncmp(argv[0], "--keep-alive-timeout-seconds=", 29) == 0) {
+      args.keep_alive_timeout_seconds = strtoul(argv[0] + 29, NULL, 10);
+      if (args.keep_alive_timeout_seconds == 0) {
+        fprintf(
+          stderr,
+          "ERROR: Invalid --keep-alive-timeout-seconds=%s entry!\n",
+          argv[0] + 29);
+        print_usage();
+        exit(1);
+      }
+    } else if (strncmp(argv[0], "--header-timeout-seconds=", 25) == 0) {
+      args.header_timeout_seconds = strtoul(argv[0] + 25, NULL, 10);
+      if (args.header_timeout_seconds == 0) {
+        fprintf(
+          stderr,
+          "ERROR: Invalid --header-timeout-seconds=%s entry!\n",
+          argv[0] + 25);
+        print_usage();
+        exit(1);
+      }
+    } else if (strncmp(argv[0], "--idle-timeout-seconds=", 23) == 0) {
+      args.idle_timeout_seconds = strtoul(argv[0] + 23, NULL, 10);
+      if (args.idle_timeout_seconds == 0) {
+        fprintf(
+          stderr,
+          "ERROR: Invalid --idle-timeout-seconds=%s entry!\n",
+          argv[0] + 23);
+        print_usage();
+        exit(1);
+      }
+    } else if (strncmp(argv[0], "--min-recv-rate=", 16) == 0) {
+      args.min_recv_rate = strtoul(argv[0] + 16, NULL, 10);
+      if (args.min_recv_rate == 0) {
+        fprintf(
+          stderr,
+          "ERROR: Invalid --min-recv-rate=%s entry!\n",
+          argv[0] + 16);
+        print_usage();
+        exit(1);
+      }
+    } else if (strncmp(argv[0], "--drain-timeout-seconds=", 24) == 0) {
+      if (argv[0][24] < '0' || argv[0][24] > '9') {
+        fprintf(
+          stderr,
+          "ERROR: Invalid --drain-timeout-seconds=%s entry!\n",
+          argv[0] + 24);
+        print_usage();
+        exit(1);
+      }
+      args.drain_timeout_seconds = strtoul(argv[0] + 24, NULL, 10);
+    } else if (strncmp(argv[0], "--keep-alive-max-requests=", 26) == 0) {
+      unsigned long value = strtoul(argv[0] + 26, NULL, 10);
+      if (value == 0 || value > UINT32_MAX) {
+        fprintf(
+          stderr,
+          "ERROR: Invalid --keep-alive-max-requests=%s entry!\n",
+          argv[0] + 26);
+        print_usage();
+        exit(1);
+      }
+      args.keep_alive_max_requests = (uint32_t)value;
+    } else if (strncmp(argv[0], "--workers=", 10) == 0) {
+      unsigned long value = strtoul(argv[0] + 10, NULL, 10);
+      if (value == 0 || value > C_SIMPLE_HTTP_MAX_WORKERS) {
+        fprintf(stderr,
+                "ERROR: Invalid --workers=%s entry (must be 1 to %u)!\n",
+                argv[0] + 10,
+                C_SIMPLE_HTTP_MAX_WORKERS);
+        print_usage();
+        exit(1);
+      }
+      args.workers = (uint32_t)value;
+    } else if (strncmp(argv[0], "--worker-cpus=", 14) == 0
+        && strlen(argv[0]) > 14) {
+      args.worker_cpus = argv[0] + 14;
+    } else if (strcmp(argv[0], "--reuseport-cpu-bpf") == 0) {
+      args.flags |= 0x80;
+    } else if (strncmp(argv[0], "--max-connections=", 18) == 0) {
+      unsigned long value = strtoul(argv[0] + 18, NULL, 10);
+      if (value == 0 || value > C_SIMPLE_HTTP_MAX_CONNECTIONS) {
+        fprintf(
+          stderr,
+          "ERROR: Invalid --max-connections=%s entry (must be 1 to %u)!\n",
+          argv[0] + 18,
+          C_SIMPLE_HTTP_MAX_CONNECTIONS);
+        print_usage();
+        exit(1);
+      }
+      args.max_connections = (uint32_t)value;
+    } else if (strncmp(argv[0], "--accept-budget=", 16) == 0) {
+      unsigned long value = strtoul(argv[0] + 16, NULL, 10);
+      if (value == 0 || value > UINT32_MAX) {
+        fprintf(
+          stderr,
+          "ERROR: Invalid --accept-budget=%s entry!\n",
+          argv[0] + 16);
+        print_usage();
+        exit(1);
+      }
+      args.accept_budget = (uint32_t)value;
+    } else if (strncmp(argv[0], "--overload-connections=", 23) == 0) {
+      unsigned long value = strtoul(argv[0] + 23, NULL, 10);
+      if (value == 0 || value > C_SIMPLE_HTTP_MAX_CONNECTIONS) {
+        fprintf(
+          stderr,
+          "ERROR: Invalid --overload-connections=%s entry (must be 1 to %u)!\n",
+          argv[0] + 23,
+          C_SIMPLE_HTTP_MAX_CONNECTIONS);
+        print_usage();
+        exit(1);
+      }
+      args.overload_connections = (uint32_t)value;
+    } else if (strncmp(argv[0], "--overload-queued-bytes=", 24) == 0) {
+      unsigned long long value = strtoull(argv[0] + 24, NULL, 10);
+      if (value == 0 || value > SIZE_MAX) {
+        fprintf(
+          stderr,
+          "ERROR: Invalid --overload-queued-bytes=%s entry!\n",
+          argv[0] + 24);
+        print_usage();
+        exit(1);
+      }
+      args.overload_queued_bytes = (size_t)value;
+    } else if (strcmp(argv[0], "--overload-reject") == 0) {
+      args.flags |= 0x40;
+    } else if (strncmp(argv[0], "--rate-limit=", 13) == 0) {
+      unsigned long value = strtoul(argv[0] + 13, NULL, 10);
+      if (value == 0 || value > C_SIMPLE_HTTP_RATE_LIMIT_MAX) {
+        fprintf(
+          stderr,
+          "ERROR: Invalid --rate-limit=%s entry (must be 1 to %u)!\n",
+          argv[0] + 13,
+          C_SIMPLE_HTTP_RATE_LIMIT_MAX);
+        print_usage();
+        exit(1);
+      }
+      args.rate_limit = (uint32_t)value;
+    } else if (strncmp(argv[0], "--rate-limit-burst=", 19) == 0) {
+      unsigned long value = strtoul(argv[0] + 19, NULL, 10);
+      if (value == 0 || value > C_SIMPLE_HTTP_RATE_LIMIT_MAX) {
+        fprintf(
+          stderr,
+          "ERROR: Invalid --rate-limit-burst=%s entry (must be 1 to %u)!\n",
+          argv[0] + 19,
+          C_SIMPLE_HTTP_RATE_LIMIT_MAX);
+        print_usage();
+        exit(1);
+      }
+      args.rate_limit_burst = (uint32_t)value;
+    } else if (strncmp(argv[0], "--listen-backlog=", 17) == 0) {
+      unsigned long value = strtoul(argv[0] + 17, NULL, 10);
+      if (value == 0 || value > INT32_MAX) {
+        fprintf(
+          stderr,
+          "ERROR: Invalid --listen-backlog=%s entry!\n",
+          argv[0] + 17);
+        print_usage();
+        exit(1);
+      }
+      args.listen_backlog = (uint32_t)value;
+    } else if (strncmp(argv[0], "--tcp-defer-accept=", 19) == 0) {
+      unsigned long value = strtoul(argv[0] + 19, NULL, 10);
+      if (value == 0 || value > INT32_MAX) {
+        fprintf(
+          stderr,
+          "ERROR: Invalid --tcp-defer-accept=%s entry!\n",
+          argv[0] + 19);
+        print_usage();
+        exit(1);
+      }
+      args.tcp_defer_accept_seconds = (uint32_t)value;
+    } else if (strncmp(argv[0], "--tcp-fastopen=", 15) == 0) {
+      unsigned long value = strtoul(argv[0] + 15, NULL, 10);
+      if (value == 0 || value > INT32_MAX) {
+        fprintf(
+          stderr,
+          "ERROR: Invalid --tcp-fastopen=%s entry!\n",
+          argv[0] + 15);
+        print_usage();
+        exit(1);
+      }
+      args.tcp_fastopen_queue_length = (uint32_t)value;
+    } else if (strcmp(argv[0], "--enable-reuse-addr") == 0) {
+      args.flags |= 0x20;
+    } else if (strcmp(argv[0], "--enable-io-uring") == 0) {
+      args.flags |= 0x10;
     } else {
       fprintf(stderr, "ERROR: Invalid args!\n");
       print_usage();
@@ -202,9 +461,14 @@ Args parse_args(int32_t argc, char **argv) {
     ++argv;
   }
 
+  if (args.rate_limit_burst == 0) {
+    args.rate_limit_burst = args.rate_limit;
+  }
+
   // Prevent freeing of Args due to successful parsing.
   Args to_return = args;
   args.list_of_headers_to_log = NULL;
+  args.listen_addrs = NULL;
   return to_return;
 }
 
@@ -213,6 +477,9 @@ void c_simple_http_free_args(Args *args) {
     if (args->list_of_headers_to_log) {
       simple_archiver_list_free(&args->list_of_headers_to_log);
     }
+    if (args->listen_addrs) {
+      simple_archiver_list_free(&args->listen_addrs);
+    }
   }
 }
 
@@ -30,16 +30,67 @@ typedef struct Args {
   // xxxx xx1x - enable listen on config file for reloading.
   // xxxx x1xx - enable overwrite on generate.
   // xxxx 1xxx - enable overwrite on generate for static dir.
+  // xxx1 xxxx - use io_uring instead of epoll.
+  // xx1x xxxx - set SO_REUSEADDR on the listening socket(s).
+  // x1xx xxxx - when overloaded, reject new connections with a 503 instead of
+  //             not accepting them.
+  // 1xxx xxxx - steer connections to the worker on the receiving CPU with a
+  //             SO_REUSEPORT BPF program.
   uint16_t flags;
   uint16_t port;
+  // Number of threads handling connections, each with its own listener.
+  uint32_t workers;
+  // CPU sets to pin the workers to, see c_simple_http_cpu_list_count(). NULL
+  // if not set, otherwise points to a string in argv.
+  const char *worker_cpus;
+  // Max number of open connections, split evenly between the workers.
+  uint32_t max_connections;
+  // Max connections accepted per event loop wake up (epoll only).
+  uint32_t accept_budget;
+  // High-water marks, split evenly between the workers like
+  // "max_connections". An event loop with at least this many connections or
+  // unsent bytes is overloaded until it drops below
+  // C_SIMPLE_HTTP_OVERLOAD_RESUME_PERCENT of both. 0 if not set.
+  uint32_t overload_connections;
+  size_t overload_queued_bytes;
+  // Requests per second allowed per client IPv4 address or IPv6 /64, 0 if not
+  // limited.
+  uint32_t rate_limit;
+  // Requests a client may make at once before being limited to "rate_limit".
+  uint32_t rate_limit_burst;
+  // Backlog passed to listen().
+  uint32_t listen_backlog;
+  // TCP_DEFER_ACCEPT timeout in seconds, 0 if not set.
+  uint32_t tcp_defer_accept_seconds;
+  // TCP_FASTOPEN queue length, 0 if not set.
+  uint32_t tcp_fastopen_queue_length;
   // Does not need to be free'd, this should point to a string in argv.
   const char *config_file;
   // Needs to be free'd.
   SDArchiverLinkedList *list_of_headers_to_log;
+  // Addresses from "--listen=...", the list needs to be free'd but its
+  // entries point to strings in argv.
+  SDArchiverLinkedList *listen_addrs;
   // Non-NULL if cache-dir is specified and cache is to be used.
   // Does not need to be free'd since it points to a string in argv.
   const char *cache_dir;
   size_t cache_lifespan_seconds;
+  // Idle connections are closed after this many seconds.
+  size_t keep_alive_timeout_seconds;
+  // Connections are closed if a request's headers are not received within
+  // this many seconds of its first byte (or of connecting).
+  size_t header_timeout_seconds;
+  // Connections are closed if sending a response makes no progress for this
+  // many seconds.
+  size_t idle_timeout_seconds;
+  // Connections receiving a request's headers slower than this many bytes per
+  // second are closed. 0 if not set.
+  size_t min_recv_rate;
+  // Connections are closed after this many requests. 1 disables keep-alive.
+  uint32_t keep_alive_max_requests;
+  // On SIGTERM/SIGINT (or after SIGUSR2), connections still open after this
+  // many seconds are closed. 0 closes them right away.
+  size_t drain_timeout_seconds;
   // Non-NULL if static-dir is specified and files in the dir are to be served.
   // Does not need to be free'd since it points to a string in argv.
   const char *static_dir;
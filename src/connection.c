@@ -0,0 +1,604 @@
+// ISC License
+// 
+// Copyright (c) 2026 Stephen Seo
+// 
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "connection.h"
+
+// Standard library includes.
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+
+// Linux/Unix includes.
+#include <sys/uio.h>
+#include <unistd.h>
+#include <errno.h>
+
+// Third party includes.
+#include <SimpleArchiver/src/helpers.h>
+#include <SimpleArchiver/src/data_structures/linked_list.h>
+
+// Local includes.
+#include "constants.h"
+#include "globals.h"
+#include "helpers.h"
+#include "rate_limit.h"
+#include "static.h"
+
+#define CHECK_ERROR_QUEUE(queue_expr) \
+  if ((queue_expr) != 0) { \
+    fprintf(stderr, "ERROR Failed to queue response to peer, closing...\n"); \
+    return 1; \
+  }
+
+// Constant response header fragments. These are queued without copying, so
+// each is a single iovec.
+#define C_SIMPLE_HTTP_INTERNAL_OK_CLOSE \
+  "HTTP/1.1 200 OK\nAllow: GET, HEAD\nConnection: close\n"
+#define C_SIMPLE_HTTP_INTERNAL_OK_KEEP_ALIVE \
+  "HTTP/1.1 200 OK\nAllow: GET, HEAD\nConnection: keep-alive\n"
+#define C_SIMPLE_HTTP_INTERNAL_HTML_HEADERS \
+  "Content-Type: text/html\nContent-Length: "
+
+const char c_simple_http_internal_html_close[] =
+  C_SIMPLE_HTTP_INTERNAL_OK_CLOSE C_SIMPLE_HTTP_INTERNAL_HTML_HEADERS;
+const char c_simple_http_internal_html_keep_alive[] =
+  C_SIMPLE_HTTP_INTERNAL_OK_KEEP_ALIVE C_SIMPLE_HTTP_INTERNAL_HTML_HEADERS;
+const char c_simple_http_internal_static_close[] =
+  C_SIMPLE_HTTP_INTERNAL_OK_CLOSE "Content-Type: ";
+const char c_simple_http_internal_static_keep_alive[] =
+  C_SIMPLE_HTTP_INTERNAL_OK_KEEP_ALIVE "Content-Type: ";
+const char c_simple_http_internal_static_content_length[] =
+  "\nContent-Length: ";
+
+/// Queues the Content-Length value and the end of the headers.
+/// Returns zero on success.
+int c_simple_http_internal_queue_content_length(
+    C_SIMPLE_HTTP_OutputQueue *out, uint64_t content_length) {
+  char buf[C_SIMPLE_HTTP_OUTPUT_INLINE_SIZE];
+  int written = snprintf(buf, sizeof(buf), "%" PRIu64 "\n\n", content_length);
+  if (written <= 0 || (size_t)written >= sizeof(buf)) {
+    return 1;
+  }
+  return c_simple_http_output_queue_add_copy(out, buf, (size_t)written);
+}
+
+void c_simple_http_print_ipv6_addr(FILE *out, const struct in6_addr *addr) {
+  for (uint32_t idx = 0; idx < 16; ++idx) {
+    if (idx % 2 == 0 && idx > 0) {
+      fprintf(out, ":");
+    }
+    fprintf(out, "%02x", addr->s6_addr[idx]);
+  }
+}
+
+void c_simple_http_connection_item_close(ConnectionItem *citem) {
+  if (citem->fd >= 0) {
+#ifndef NDEBUG
+    fprintf(stderr, "Closed connection to peer ");
+    c_simple_http_print_ipv6_addr(stderr, &citem->peer_addr);
+    fprintf(stderr, ", fd %d\n", citem->fd);
+#endif
+    if ((citem->flags & 8) == 0) {
+      close(citem->fd);
+    }
+    citem->fd = -1;
+  }
+  c_simple_http_timer_cancel(&citem->timer);
+  c_simple_http_output_queue_clear(&citem->out);
+  citem->in.size = 0;
+  citem->in_scan = 0;
+}
+
+void c_simple_http_connection_item_reuse(ConnectionItem *citem) {
+  C_SIMPLE_HTTP_OutputQueue out = citem->out;
+  C_SIMPLE_HTTP_Buffer in = citem->in;
+  memset(citem, 0, sizeof(ConnectionItem));
+  citem->fd = -1;
+  citem->out = out;
+  citem->in = in;
+}
+
+void c_simple_http_cleanup_connection_item(ConnectionItem *citem) {
+  if (citem) {
+    c_simple_http_connection_item_close(citem);
+    c_simple_http_output_queue_cleanup(&citem->out);
+    c_simple_http_buffer_cleanup(&citem->in);
+  }
+}
+
+int c_simple_http_headers_check_print(void *data, void *ud) {
+  const C_SIMPLE_HTTP_ParsedRequest *request = ud;
+  const char *header_c_str = data;
+
+  const C_SIMPLE_HTTP_Header *header = c_simple_http_request_get_header(
+    request, header_c_str, strlen(header_c_str));
+  if (header) {
+    printf("Printing header line: %.*s: %.*s\n",
+           (int)header->name.size, header->name.ptr,
+           (int)header->value.size, header->value.ptr);
+  }
+  return 0;
+}
+
+int c_simple_http_on_error(
+    enum C_SIMPLE_HTTP_ResponseCode response_code,
+    C_SIMPLE_HTTP_OutputQueue *out
+) {
+  const char *response = c_simple_http_response_code_error_to_response(
+    response_code);
+  if (response) {
+    return c_simple_http_output_queue_add_ref(out, response, strlen(response));
+  } else {
+    const char *fallback =
+      "HTTP/1.1 500 Internal Server Error\n"
+      "Allow: GET, HEAD\n"
+      "Connection: close\n"
+      "Content-Type: text/html\n"
+      "Content-Length: 35\n"
+      "\n<h1>500 Internal Server Error</h1>\n";
+    return c_simple_http_output_queue_add_ref(out, fallback, strlen(fallback));
+  }
+}
+
+/// Queues the error response for "response_code" to "out", without its body if
+/// "is_head" is non-zero.
+/// Returns zero on success.
+int c_simple_http_internal_on_error(
+    int_fast8_t is_head,
+    enum C_SIMPLE_HTTP_ResponseCode response_code,
+    C_SIMPLE_HTTP_OutputQueue *out) {
+  if (is_head) {
+    const char *response = c_simple_http_response_code_error_to_response(
+      response_code);
+    const char *body = response ? strstr(response, "\n\n") : NULL;
+    if (body) {
+      return c_simple_http_output_queue_add_ref(
+        out, response, (size_t)(body + 2 - response));
+    }
+  }
+  return c_simple_http_on_error(response_code, out);
+}
+
+/// Returns 1 if the request starting at "buf" (which need not be parsed or
+/// complete) is a HEAD request.
+int_fast8_t c_simple_http_internal_is_head_request_line(const char *buf,
+                                                        size_t size) {
+  return size >= 5 && memcmp(buf, "HEAD ", 5) == 0 ? 1 : 0;
+}
+
+int64_t c_simple_http_connection_timeout_remaining(
+    const ConnectionItem *citem,
+    const ConnectionContext *ctx) {
+  const Args *args = ctx->args;
+  if ((citem->flags & 0x40) != 0 && citem->out.size == 0) {
+    int64_t deadline = (int64_t)args->header_timeout_seconds * 1000;
+    if (args->min_recv_rate != 0 && citem->request_bytes != 0) {
+      // The time by which the bytes received so far should have been
+      // received at the min rate.
+      int64_t rate_deadline =
+        (int64_t)(citem->request_bytes * 1000 / args->min_recv_rate);
+      if (rate_deadline < C_SIMPLE_HTTP_MIN_RECV_RATE_GRACE_MILLIS) {
+        rate_deadline = C_SIMPLE_HTTP_MIN_RECV_RATE_GRACE_MILLIS;
+      }
+      if (rate_deadline < deadline) {
+        deadline = rate_deadline;
+      }
+    }
+    return deadline
+      - c_simple_http_helper_timespec_diff_millis(&citem->request_time,
+                                                  &ctx->current_time);
+  }
+
+  // Sending a response, or waiting for the next request.
+  const int64_t timeout = citem->out.size != 0
+    ? (int64_t)args->idle_timeout_seconds
+    : (int64_t)args->keep_alive_timeout_seconds;
+  return timeout * 1000
+    - c_simple_http_helper_timespec_diff_millis(&citem->time_point,
+                                                &ctx->current_time);
+}
+
+int c_simple_http_connection_handle_request(ConnectionItem *citem,
+                                            ConnectionContext *ctx,
+                                            char *recv_buf,
+                                            size_t recv_size) {
+  const Args *args = ctx->args;
+  C_SIMPLE_HTTP_ParsedConfig *parsed = ctx->parsed;
+  C_SIMPLE_HTTP_OutputQueue *out = &citem->out;
+
+#ifndef NDEBUG
+  // DEBUG print received buf.
+  for (size_t idx = 0; idx < recv_size; ++idx) {
+    if ((recv_buf[idx] >= 0x20 && recv_buf[idx] <= 0x7E)
+        || recv_buf[idx] == '\n' || recv_buf[idx] == '\r') {
+      printf("%c", recv_buf[idx]);
+    } else {
+      break;
+    }
+  }
+  puts("");
+#endif
+  // The request is parsed once, and the views into "recv_buf" are used for
+  // logging, routing, and static serving.
+  C_SIMPLE_HTTP_ParsedRequest request;
+  int parse_ret = c_simple_http_parse_request(recv_buf, recv_size, &request);
+  citem->flags &= ~(uint32_t)0x10;
+  if (parse_ret != 0) {
+    fprintf(stderr, "WARNING Received an invalid request!\n");
+    return c_simple_http_internal_on_error(
+      c_simple_http_request_is_head(&request) ? 1 : 0,
+      parse_ret == 2
+        ? C_SIMPLE_HTTP_Response_431_Request_Header_Fields_Too_Large
+        : C_SIMPLE_HTTP_Response_400_Bad_Request,
+      out);
+  }
+  // HEAD is routed like GET, but only the headers are sent.
+  const int_fast8_t is_head = c_simple_http_request_is_head(&request) ? 1 : 0;
+
+  simple_archiver_list_get(
+    args->list_of_headers_to_log,
+    c_simple_http_headers_check_print,
+    &request);
+  if (!c_simple_http_request_connection_close(&request)
+      && citem->request_count + 1 < args->keep_alive_max_requests
+      && !C_SIMPLE_HTTP_DRAINING) {
+    citem->flags |= 0x10;
+  }
+  const int_fast8_t keep_alive = (citem->flags & 0x10) != 0 ? 1 : 0;
+
+  size_t response_size = 0;
+  enum C_SIMPLE_HTTP_ResponseCode response_code;
+  __attribute__((cleanup(simple_archiver_helper_cleanup_c_string)))
+  char *response = NULL;
+  int_fast8_t needs_write_lock = 0;
+  if (ctx->config_lock) {
+    pthread_rwlock_rdlock(ctx->config_lock);
+  }
+  response = c_simple_http_request_response(
+    &request,
+    parsed,
+    &response_size,
+    &response_code,
+    args,
+    ctx->config_lock ? &needs_write_lock : NULL);
+  if (ctx->config_lock) {
+    pthread_rwlock_unlock(ctx->config_lock);
+  }
+  if (needs_write_lock) {
+    // Updating an out of date cache entry may reload (modify) the config. The
+    // entry is checked again, as another thread may have updated it already.
+    pthread_rwlock_wrlock(ctx->config_lock);
+    response = c_simple_http_request_response(
+      &request,
+      parsed,
+      &response_size,
+      &response_code,
+      args,
+      NULL);
+    pthread_rwlock_unlock(ctx->config_lock);
+  }
+  if (response_code == C_SIMPLE_HTTP_Response_200_OK) {
+    if (keep_alive) {
+      CHECK_ERROR_QUEUE(c_simple_http_output_queue_add_ref(
+        out,
+        c_simple_http_internal_html_keep_alive,
+        sizeof(c_simple_http_internal_html_keep_alive) - 1));
+    } else {
+      CHECK_ERROR_QUEUE(c_simple_http_output_queue_add_ref(
+        out,
+        c_simple_http_internal_html_close,
+        sizeof(c_simple_http_internal_html_close) - 1));
+    }
+    CHECK_ERROR_QUEUE(
+      c_simple_http_internal_queue_content_length(out, response_size));
+    if (response) {
+      // The queue takes ownership of the response.
+      char *body = response;
+      response = NULL;
+      CHECK_ERROR_QUEUE(
+        c_simple_http_output_queue_add_owned(out, body, response_size));
+    }
+  } else if (
+      response_code == C_SIMPLE_HTTP_Response_404_Not_Found
+      && args->static_dir) {
+    __attribute__((cleanup(c_simple_http_cleanup_static_file_info)))
+    C_SIMPLE_HTTP_StaticFileInfo file_info =
+      c_simple_http_get_file(args->static_dir, request.path.ptr, 0, is_head);
+    if (file_info.result == STATIC_FILE_RESULT_NoXDGMimeAvailable) {
+      file_info = c_simple_http_get_file(
+        args->static_dir, request.path.ptr, 1, is_head);
+    }
+
+    if (file_info.result != STATIC_FILE_RESULT_OK
+        || (!file_info.buf && !is_head)
+        || file_info.buf_size == 0
+        || !file_info.mime_type) {
+      if (file_info.result == STATIC_FILE_RESULT_FileError
+          || file_info.result == STATIC_FILE_RESULT_InternalError) {
+        response_code = C_SIMPLE_HTTP_Response_500_Internal_Server_Error;
+      } else if (file_info.result == STATIC_FILE_RESULT_InvalidParameter) {
+        response_code = C_SIMPLE_HTTP_Response_400_Bad_Request;
+      } else if (file_info.result == STATIC_FILE_RESULT_404NotFound) {
+        response_code = C_SIMPLE_HTTP_Response_404_Not_Found;
+      } else if (file_info.result == STATIC_FILE_RESULT_InvalidPath) {
+        response_code = C_SIMPLE_HTTP_Response_400_Bad_Request;
+      } else {
+        response_code = C_SIMPLE_HTTP_Response_500_Internal_Server_Error;
+      }
+
+      // Error responses always close the connection.
+      citem->flags &= ~(uint32_t)0x10;
+      return c_simple_http_internal_on_error(is_head, response_code, out);
+    } else {
+      if (keep_alive) {
+        CHECK_ERROR_QUEUE(c_simple_http_output_queue_add_ref(
+          out,
+          c_simple_http_internal_static_keep_alive,
+          sizeof(c_simple_http_internal_static_keep_alive) - 1));
+      } else {
+        CHECK_ERROR_QUEUE(c_simple_http_output_queue_add_ref(
+          out,
+          c_simple_http_internal_static_close,
+          sizeof(c_simple_http_internal_static_close) - 1));
+      }
+      // The queue takes ownership of the mime type and the file's contents.
+      char *mime_type = file_info.mime_type;
+      file_info.mime_type = NULL;
+      CHECK_ERROR_QUEUE(c_simple_http_output_queue_add_owned(
+        out, mime_type, strlen(mime_type)));
+      CHECK_ERROR_QUEUE(c_simple_http_output_queue_add_ref(
+        out,
+        c_simple_http_internal_static_content_length,
+        sizeof(c_simple_http_internal_static_content_length) - 1));
+      CHECK_ERROR_QUEUE(c_simple_http_internal_queue_content_length(
+        out, file_info.buf_size));
+      if (file_info.buf) {
+        char *file_buf = file_info.buf;
+        file_info.buf = NULL;
+        CHECK_ERROR_QUEUE(c_simple_http_output_queue_add_owned(
+          out, file_buf, file_info.buf_size));
+      }
+      fprintf(stderr,
+              "NOTICE Found static file for path \"%s\"\n",
+              request.path.ptr);
+    }
+  } else {
+    citem->flags &= ~(uint32_t)0x10;
+    return c_simple_http_internal_on_error(is_head, response_code, out);
+  }
+
+  return 0;
+}
+
+void c_simple_http_connection_reset(ConnectionItem *citem,
+                                    const ConnectionContext *ctx) {
+  citem->flags &= ~(uint32_t)0x10;
+  ++citem->request_count;
+  citem->time_point = ctx->current_time;
+}
+
+int c_simple_http_connection_handle_input(ConnectionItem *citem,
+                                          ConnectionContext *ctx,
+                                          char *buf,
+                                          size_t size) {
+  if (buf && size != 0) {
+    if ((citem->flags & 0x40) == 0) {
+      // The first bytes of a new request.
+      citem->flags |= 0x40;
+      citem->request_time = ctx->current_time;
+      citem->request_bytes = 0;
+    }
+    citem->request_bytes += size;
+  }
+
+  // Received bytes are handled in place if nothing is pending.
+  if (citem->in.size != 0 || !buf) {
+    if (buf && c_simple_http_buffer_append(&citem->in, buf, size) != 0) {
+      fprintf(stderr, "ERROR Failed to buffer request from peer, closing...\n");
+      return 1;
+    }
+    buf = citem->in.buf;
+    size = citem->in.size;
+  }
+
+  size_t idx = 0;
+  int_fast8_t handled = 0;
+  while (1) {
+    if (citem->in_scan == 0) {
+      // Empty lines before a request are ignored.
+      while (idx < size && (buf[idx] == '\r' || buf[idx] == '\n')) {
+        ++idx;
+      }
+    }
+    if (idx >= size) {
+      break;
+    }
+
+    size_t request_size = c_simple_http_request_headers_end(buf + idx,
+                                                            size - idx,
+                                                            &citem->in_scan);
+    if (request_size == 0) {
+      if (size - idx > C_SIMPLE_HTTP_MAX_REQUEST_SIZE) {
+        fprintf(stderr, "WARNING Request headers from peer are too large!\n");
+        c_simple_http_internal_on_error(
+          c_simple_http_internal_is_head_request_line(buf + idx, size - idx),
+          C_SIMPLE_HTTP_Response_431_Request_Header_Fields_Too_Large,
+          &citem->out);
+        citem->in.size = 0;
+        return 1;
+      }
+      break;
+    }
+    citem->in_scan = 0;
+
+    if (ctx->rate_limiter
+        && c_simple_http_rate_limiter_take(ctx->rate_limiter,
+                                           &citem->peer_addr,
+                                           &ctx->current_time) != 0) {
+      fprintf(stderr, "Peer ");
+      c_simple_http_print_ipv6_addr(stderr, &citem->peer_addr);
+      fprintf(stderr, " is over the rate limit.\n");
+      c_simple_http_internal_on_error(
+        c_simple_http_internal_is_head_request_line(buf + idx, request_size),
+        C_SIMPLE_HTTP_Response_429_Too_Many_Requests,
+        &citem->out);
+      citem->in.size = 0;
+      return 1;
+    }
+
+    if (c_simple_http_connection_handle_request(
+          citem, ctx, buf + idx, request_size) != 0
+        || (citem->flags & 0x10) == 0) {
+      // Any following requests are ignored as the connection will close.
+      citem->in.size = 0;
+      return 1;
+    }
+    c_simple_http_connection_reset(citem, ctx);
+    idx += request_size;
+    handled = 1;
+
+    if (citem->out.size >= C_SIMPLE_HTTP_OUTPUT_HIGH_WATER_MARK) {
+      // Backpressure, the rest is handled once the responses are sent.
+      break;
+    }
+  }
+
+  // Keep the incomplete request until the rest of it is received.
+  if (buf == citem->in.buf) {
+    memmove(citem->in.buf, citem->in.buf + idx, size - idx);
+    citem->in.size = size - idx;
+  } else if (idx < size
+      && c_simple_http_buffer_append(&citem->in, buf + idx, size - idx) != 0) {
+    fprintf(stderr, "ERROR Failed to buffer request from peer, closing...\n");
+    return 1;
+  }
+
+  if (citem->in.size == 0) {
+    citem->flags &= ~(uint32_t)0x40;
+  } else if (handled) {
+    // The rest is the start of the next request.
+    citem->flags |= 0x40;
+    citem->request_time = ctx->current_time;
+    citem->request_bytes = citem->in.size;
+  }
+  if (ctx->timers && c_simple_http_timer_is_scheduled(&citem->timer)) {
+    c_simple_http_timer_wheel_schedule(
+      ctx->timers,
+      &citem->timer,
+      &ctx->current_time,
+      c_simple_http_connection_timeout_remaining(citem, ctx));
+  }
+
+  return 0;
+}
+
+int c_simple_http_connection_flush(ConnectionItem *citem) {
+  struct iovec iovecs[C_SIMPLE_HTTP_OUTPUT_MAX_IOVECS];
+  while (citem->out.size != 0) {
+    int iovec_count = c_simple_http_output_queue_to_iovecs(
+      &citem->out, iovecs, C_SIMPLE_HTTP_OUTPUT_MAX_IOVECS);
+    ssize_t write_ret = writev(citem->fd, iovecs, iovec_count);
+    if (write_ret < 0) {
+      if (errno == EINTR) {
+        continue;
+      } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        return 2;
+      }
+      fprintf(stderr, "ERROR Failed to write to connected peer, closing...\n");
+      return 1;
+    }
+    c_simple_http_output_queue_consume(&citem->out, (size_t)write_ret);
+  }
+
+  return 0;
+}
+
+/// Sends "citem->out", handling the requests that were deferred while it was
+/// being sent.
+/// Returns zero if everything was sent, 1 if the connection should be closed,
+/// or 2 if waiting for the connection to be writable.
+int c_simple_http_internal_connection_send(ConnectionItem *citem,
+                                           ConnectionContext *ctx) {
+  while (1) {
+    const int_fast8_t had_output = citem->out.size != 0 ? 1 : 0;
+    int ret = c_simple_http_connection_flush(citem);
+    if (ret != 0) {
+      return ret;
+    } else if ((citem->flags & 0x20) != 0) {
+      return 1;
+    } else if (!had_output) {
+      return 0;
+    }
+
+    // Sending made progress, so the connection is not idle.
+    citem->time_point = ctx->current_time;
+    if (citem->in.size == 0) {
+      return 0;
+    } else if (c_simple_http_connection_handle_input(citem, ctx, NULL, 0)
+               != 0) {
+      citem->flags |= 0x20;
+    } else if (citem->out.size == 0) {
+      // Only an incomplete request is left.
+      return 0;
+    }
+  }
+}
+
+int c_simple_http_manage_connections(void *data, void *ud) {
+  ConnectionItem *citem = data;
+  ConnectionContext *ctx = ud;
+  char *recv_buf = ctx->buf;
+
+  // Nothing more is read until the pending responses are sent.
+  int ret = c_simple_http_internal_connection_send(citem, ctx);
+  if (ret != 0) {
+    return ret == 1 ? 1 : 0;
+  }
+
+  // Edge-triggered, so read until there is nothing left to read.
+  while (1) {
+    ssize_t read_ret = read(citem->fd, recv_buf, C_SIMPLE_HTTP_RECV_BUF_SIZE);
+    if (read_ret < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        return 0;
+      } else if (errno == EINTR) {
+        continue;
+      } else {
+        fprintf(stderr, "Peer ");
+        c_simple_http_print_ipv6_addr(stderr, &citem->peer_addr);
+        fprintf(stderr, " error.\n");
+        return 1;
+      }
+    } else if (read_ret == 0) {
+      // Peer closed the connection.
+      return 1;
+    }
+
+    // All responses to the received requests are sent together.
+    if (c_simple_http_connection_handle_input(
+          citem, ctx, recv_buf, (size_t)read_ret) != 0) {
+      citem->flags |= 0x20;
+    }
+    ret = c_simple_http_internal_connection_send(citem, ctx);
+    if (ret != 0) {
+      // Sending resumes once the connection is writable (EPOLLOUT).
+      return ret == 1 ? 1 : 0;
+    }
+  }
+}
+
+// vim: et ts=2 sts=2 sw=2
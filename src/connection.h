@@ -0,0 +1,141 @@
+// ISC License
+// 
+// Copyright (c) 2026 Stephen Seo
+// 
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef SEODISPARATE_COM_C_SIMPLE_HTTP_CONNECTION_H_
+#define SEODISPARATE_COM_C_SIMPLE_HTTP_CONNECTION_H_
+
+// Standard library includes.
+#include <stdio.h>
+
+// Linux/Unix includes.
+#include <netinet/in.h>
+#include <time.h>
+
+// Local includes.
+#include "helpers.h"
+#include "http.h"
+#include "output_queue.h"
+#include "timer_wheel.h"
+
+typedef struct ConnectionItem {
+  int fd;
+  // xxxx xxx1 - io_uring recv is in-flight.
+  // xxxx xx1x - io_uring send is in-flight.
+  // xxxx x1xx - connection is closing.
+  // xxxx 1xxx - io_uring close was submitted.
+  // xxx1 xxxx - keep the connection alive after the response is sent.
+  // xx1x xxxx - close the connection once "out" is sent.
+  // x1xx xxxx - receiving a request's headers, since "request_time".
+  // 1xxx xxxx - io_uring recv is waiting for provided buffers.
+  uint32_t flags;
+  // Number of requests that were responded to on this connection.
+  uint32_t request_count;
+  // Time of connection, or of the last response if kept alive.
+  struct timespec time_point;
+  // Time of connection, or of the first byte of the request being received.
+  struct timespec request_time;
+  // Bytes received of the request being received.
+  size_t request_bytes;
+  // Scheduled on the event loop's timer wheel while the connection is open.
+  C_SIMPLE_HTTP_TimerEntry timer;
+  struct in6_addr peer_addr;
+  // The response(s) to send to the peer.
+  C_SIMPLE_HTTP_OutputQueue out;
+  // Received bytes that are not handled yet.
+  C_SIMPLE_HTTP_Buffer in;
+  // Where the search for the end of the headers resumes in "in".
+  size_t in_scan;
+} ConnectionItem;
+
+void c_simple_http_print_ipv6_addr(FILE *out, const struct in6_addr *addr);
+
+/// Closes the connection's fd (unless io_uring closed it) and drops any
+/// unsent or unhandled bytes. The buffers' allocations are kept.
+void c_simple_http_connection_item_close(ConnectionItem *citem);
+
+/// Zeroes a closed ConnectionItem for a new connection, keeping the buffers'
+/// allocations.
+void c_simple_http_connection_item_reuse(ConnectionItem *citem);
+
+/// Closes the connection and frees its buffers, but not the ConnectionItem.
+void c_simple_http_cleanup_connection_item(ConnectionItem *citem);
+
+/// For simple_archiver_list_get over "--req-header-to-print" headers. Prints
+/// the header named by "data" if the C_SIMPLE_HTTP_ParsedRequest "ud" has it.
+int c_simple_http_headers_check_print(void *data, void *ud);
+
+/// Queues the error response for "response_code" to "out".
+/// Returns zero on success.
+int c_simple_http_on_error(
+  enum C_SIMPLE_HTTP_ResponseCode response_code,
+  C_SIMPLE_HTTP_OutputQueue *out
+);
+
+/// Returns the milliseconds until the connection times out, which is zero or
+/// negative if it has timed out. A request's headers must be received within
+/// "--header-timeout-seconds" and at "--min-recv-rate", a response must make
+/// progress within "--idle-timeout-seconds", and the next request must start
+/// within "--keep-alive-timeout-seconds".
+int64_t c_simple_http_connection_timeout_remaining(
+  const ConnectionItem *citem,
+  const ConnectionContext *ctx);
+
+/// Handles a received request, queueing the full response to "citem->out".
+/// If the connection is to be kept alive after the response, "citem->flags"
+/// will have 0x10 set.
+/// Returns zero on success, non-zero if the connection should be closed
+/// without sending a response.
+int c_simple_http_connection_handle_request(ConnectionItem *citem,
+                                            ConnectionContext *ctx,
+                                            char *recv_buf,
+                                            size_t recv_size);
+
+/// Resets the per-request state of a kept alive connection after a request
+/// was handled, so that it can handle the next request.
+void c_simple_http_connection_reset(ConnectionItem *citem,
+                                    const ConnectionContext *ctx);
+
+/// Handles all complete (pipelined) requests in "citem->in" followed by "buf"
+/// in order, queueing their responses to "citem->out". A request is complete
+/// once the end of its headers is received, and the remaining bytes are kept
+/// in "citem->in". Requests stop being handled once "citem->out" reaches
+/// C_SIMPLE_HTTP_OUTPUT_HIGH_WATER_MARK, and should be handled after it is
+/// sent. "buf" may be NULL to only handle "citem->in". Requests are parsed in
+/// place, so their bytes in "buf" or "citem->in" are modified.
+/// The connection's timer is rescheduled (if it is scheduled on
+/// "ctx->timers") for the connection's new timeout.
+/// Returns zero if the connection is kept alive, non-zero if the connection
+/// is to be closed after "citem->out" is sent.
+int c_simple_http_connection_handle_input(ConnectionItem *citem,
+                                          ConnectionContext *ctx,
+                                          char *buf,
+                                          size_t size);
+
+/// Writes the unsent bytes of "citem->out" to the connection with writev,
+/// until everything is written or the connection's send buffer is full.
+/// Returns zero if everything was written, 1 on error, or 2 if there are
+/// unsent bytes left to write once the connection is writable.
+int c_simple_http_connection_flush(ConnectionItem *citem);
+
+/// "data" must be a ConnectionItem and "ud" must be a ConnectionContext.
+/// Should be called when the connection's fd is readable.
+/// Returns zero if the connection is kept alive.
+/// Returns non-zero if the connection is to be closed.
+int c_simple_http_manage_connections(void *data, void *ud);
+
+#endif
+
+// vim: et ts=2 sts=2 sw=2
@@ -0,0 +1,82 @@
+// ISC License
+// 
+// Copyright (c) 2026 Stephen Seo
+// 
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "connection_pool.h"
+
+// Standard library includes.
+#include <stdlib.h>
+#include <string.h>
+
+int c_simple_http_connection_pool_init(C_SIMPLE_HTTP_ConnectionPool *pool,
+                                       uint32_t capacity) {
+  memset(pool, 0, sizeof(C_SIMPLE_HTTP_ConnectionPool));
+  pool->items = calloc(capacity, sizeof(ConnectionItem));
+  pool->free_idxs = malloc(capacity * sizeof(uint32_t));
+  if (!pool->items || !pool->free_idxs) {
+    c_simple_http_connection_pool_cleanup(pool);
+    return 1;
+  }
+  pool->capacity = capacity;
+
+  // Pushed in reverse so that the first items are used first.
+  for (uint32_t idx = 0; idx < capacity; ++idx) {
+    pool->items[idx].fd = -1;
+    pool->items[idx].out.total = &pool->queued_bytes;
+    pool->free_idxs[idx] = capacity - 1 - idx;
+  }
+  pool->free_count = capacity;
+  return 0;
+}
+
+void c_simple_http_connection_pool_cleanup(C_SIMPLE_HTTP_ConnectionPool *pool) {
+  if (pool->items) {
+    for (uint32_t idx = 0; idx < pool->capacity; ++idx) {
+      c_simple_http_cleanup_connection_item(&pool->items[idx]);
+    }
+    free(pool->items);
+    pool->items = NULL;
+  }
+  free(pool->free_idxs);
+  pool->free_idxs = NULL;
+  pool->capacity = 0;
+  pool->free_count = 0;
+}
+
+ConnectionItem *c_simple_http_connection_pool_acquire(
+    C_SIMPLE_HTTP_ConnectionPool *pool,
+    int fd) {
+  if (pool->free_count == 0 || fd < 0) {
+    return NULL;
+  }
+
+  ConnectionItem *citem = &pool->items[pool->free_idxs[--pool->free_count]];
+  c_simple_http_connection_item_reuse(citem);
+  citem->fd = fd;
+  return citem;
+}
+
+void c_simple_http_connection_pool_release(C_SIMPLE_HTTP_ConnectionPool *pool,
+                                           ConnectionItem *citem) {
+  c_simple_http_connection_item_close(citem);
+  pool->free_idxs[pool->free_count++] = (uint32_t)(citem - pool->items);
+}
+
+uint32_t c_simple_http_connection_pool_count(
+    const C_SIMPLE_HTTP_ConnectionPool *pool) {
+  return pool->capacity - pool->free_count;
+}
+
+// vim: et ts=2 sts=2 sw=2
@@ -0,0 +1,63 @@
+// ISC License
+// 
+// Copyright (c) 2026 Stephen Seo
+// 
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef SEODISPARATE_COM_C_SIMPLE_HTTP_CONNECTION_POOL_H_
+#define SEODISPARATE_COM_C_SIMPLE_HTTP_CONNECTION_POOL_H_
+
+// Standard library includes.
+#include <stddef.h>
+#include <stdint.h>
+
+// Local includes.
+#include "connection.h"
+
+/// Preallocated ConnectionItems for an event loop. Released items keep their
+/// buffers' allocations for the next connection.
+typedef struct C_SIMPLE_HTTP_ConnectionPool {
+  ConnectionItem *items;
+  // The first "free_count" are indices into "items" of unused items.
+  uint32_t *free_idxs;
+  uint32_t capacity;
+  uint32_t free_count;
+  // Total unsent bytes in the items' output queues.
+  size_t queued_bytes;
+} C_SIMPLE_HTTP_ConnectionPool;
+
+/// The pool must not be moved after init, as its items count their unsent
+/// bytes in "queued_bytes".
+/// Returns zero on success.
+int c_simple_http_connection_pool_init(C_SIMPLE_HTTP_ConnectionPool *pool,
+                                       uint32_t capacity);
+
+/// Closes all open connections and frees the pool.
+void c_simple_http_connection_pool_cleanup(C_SIMPLE_HTTP_ConnectionPool *pool);
+
+/// Returns a zeroed (except for its buffers) ConnectionItem for "fd", or NULL
+/// if all items are in use.
+ConnectionItem *c_simple_http_connection_pool_acquire(
+  C_SIMPLE_HTTP_ConnectionPool *pool,
+  int fd);
+
+/// Closes the connection and returns its item to the pool.
+void c_simple_http_connection_pool_release(C_SIMPLE_HTTP_ConnectionPool *pool,
+                                           ConnectionItem *citem);
+
+uint32_t c_simple_http_connection_pool_count(
+  const C_SIMPLE_HTTP_ConnectionPool *pool);
+
+#endif
+
+// vim: et ts=2 sts=2 sw=2
@@ -17,14 +17,48 @@
 #ifndef SEODISPARATE_COM_C_SIMPLE_HTTP_CONSTANTS_H_
 #define SEODISPARATE_COM_C_SIMPLE_HTTP_CONSTANTS_H_
 
-#define C_SIMPLE_HTTP_SLEEP_NANOS 1000000
 #define C_SIMPLE_HTTP_NONBLOCK_SLEEP_NANOS 1000000
-#define C_SIMPLE_HTTP_CONNECTION_TIMEOUT_SECONDS 3
+#define C_SIMPLE_HTTP_DEFAULT_HEADER_TIMEOUT_SECONDS 3
+#define C_SIMPLE_HTTP_DEFAULT_IDLE_TIMEOUT_SECONDS 5
+// "--min-recv-rate" is only checked once a request took this long.
+#define C_SIMPLE_HTTP_MIN_RECV_RATE_GRACE_MILLIS 1000
+#define C_SIMPLE_HTTP_DEFAULT_KEEP_ALIVE_TIMEOUT_SECONDS 5
+// A timed out io_uring connection whose close did not complete yet is checked
+// again after this long.
+#define C_SIMPLE_HTTP_ABORT_RETRY_MILLIS 1000
+#define C_SIMPLE_HTTP_DEFAULT_KEEP_ALIVE_MAX_REQUESTS 100
+#define C_SIMPLE_HTTP_DEFAULT_DRAIN_TIMEOUT_SECONDS 10
 #define C_SIMPLE_HTTP_MAX_NONBLOCK_WAIT_NANOS 3500000000
-#define C_SIMPLE_HTTP_TRY_CONFIG_RELOAD_NANOS 4000000000
-#define C_SIMPLE_HTTP_TRY_CONFIG_RELOAD_TICKS \
-    (C_SIMPLE_HTTP_TRY_CONFIG_RELOAD_NANOS / C_SIMPLE_HTTP_SLEEP_NANOS)
+#define C_SIMPLE_HTTP_TRY_CONFIG_RELOAD_MILLIS 4000
+#define C_SIMPLE_HTTP_UPGRADE_READY_TIMEOUT_MILLIS 10000
+#define C_SIMPLE_HTTP_TIMER_WHEEL_TICK_MILLIS 100
+#define C_SIMPLE_HTTP_TIMER_WHEEL_SLOTS 256
+#define C_SIMPLE_HTTP_EPOLL_MAX_EVENTS 64
+#define C_SIMPLE_HTTP_MAX_WORKERS 1024
+#define C_SIMPLE_HTTP_DEFAULT_MAX_CONNECTIONS 1024
+#define C_SIMPLE_HTTP_MAX_CONNECTIONS 1048576
+#define C_SIMPLE_HTTP_DEFAULT_ACCEPT_BUDGET 64
+// An overloaded event loop accepts again once its connections and unsent bytes
+// are below this percentage of the "--overload-..." high-water marks.
+#define C_SIMPLE_HTTP_OVERLOAD_RESUME_PERCENT 75
+// Must be a power of 2.
+#define C_SIMPLE_HTTP_RATE_LIMIT_TABLE_SIZE 8192
+// Max slots searched for a client's bucket.
+#define C_SIMPLE_HTTP_RATE_LIMIT_PROBES 8
+#define C_SIMPLE_HTTP_RATE_LIMIT_MAX 1000000
+#define C_SIMPLE_HTTP_DEFAULT_LISTEN_BACKLOG 64
+#define C_SIMPLE_HTTP_IO_URING_ENTRIES 256
+// Must be a power of 2.
+#define C_SIMPLE_HTTP_IO_URING_BUF_COUNT 64
 #define C_SIMPLE_HTTP_RECV_BUF_SIZE 1024
+// Max size of a request's headers, including pipelined requests received
+// while responses are being sent.
+#define C_SIMPLE_HTTP_MAX_REQUEST_SIZE 16384
+// Requests with more header lines are rejected.
+#define C_SIMPLE_HTTP_MAX_HEADERS 64
+// Pipelined requests are not handled while a connection has at least this
+// many unsent bytes.
+#define C_SIMPLE_HTTP_OUTPUT_HIGH_WATER_MARK 262144
 #define C_SIMPLE_HTTP_CONFIG_BUF_SIZE 1024
 #define C_SIMPLE_HTTP_QUOTE_COUNT_MAX 3
 #define C_SIMPLE_HTTP_TRY_CONFIG_RELOAD_MAX_ATTEMPTS 20
@@ -0,0 +1,213 @@
+// ISC License
+// 
+// Copyright (c) 2026 Stephen Seo
+// 
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+// Required for cpu_set_t and pthread_setaffinity_np().
+#define _GNU_SOURCE
+
+#include "cpu_affinity.h"
+
+// Standard library includes.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+// Linux/Unix includes.
+#include <sys/socket.h>
+#include <linux/filter.h>
+#include <pthread.h>
+#include <sched.h>
+#include <errno.h>
+
+// Third party includes.
+#include <SimpleArchiver/src/helpers.h>
+
+/// Parses the entry at "*str" into "set_out" (may be NULL), moving "*str"
+/// past it.
+/// Returns zero on success.
+int c_simple_http_internal_cpu_parse_entry(const char **str,
+                                           cpu_set_t *set_out) {
+  char *end;
+  if (**str < '0' || **str > '9') {
+    return 1;
+  }
+  const unsigned long first = strtoul(*str, &end, 10);
+  unsigned long last = first;
+  if (*end == '-') {
+    if (end[1] < '0' || end[1] > '9') {
+      return 1;
+    }
+    last = strtoul(end + 1, &end, 10);
+  }
+  if ((*end != ',' && *end != 0) || first > last || last >= CPU_SETSIZE) {
+    return 1;
+  }
+
+  if (set_out) {
+    CPU_ZERO(set_out);
+    for (unsigned long cpu = first; cpu <= last; ++cpu) {
+      CPU_SET(cpu, set_out);
+    }
+  }
+  *str = end;
+  return 0;
+}
+
+/// Sets "set_out" to the entry of worker "worker_idx".
+/// Returns zero on success.
+int c_simple_http_internal_cpu_list_get(const char *list,
+                                        uint32_t worker_idx,
+                                        cpu_set_t *set_out) {
+  const uint32_t count = c_simple_http_cpu_list_count(list);
+  if (count == 0) {
+    return 1;
+  }
+  for (uint32_t idx = 0; idx < worker_idx % count; ++idx) {
+    c_simple_http_internal_cpu_parse_entry(&list, NULL);
+    ++list;
+  }
+  return c_simple_http_internal_cpu_parse_entry(&list, set_out);
+}
+
+/// Returns the CPU if "set" has exactly one, or -1.
+int c_simple_http_internal_cpu_single(const cpu_set_t *set) {
+  if (CPU_COUNT(set) != 1) {
+    return -1;
+  }
+  for (size_t cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, set)) {
+      return (int)cpu;
+    }
+  }
+  return -1;
+}
+
+uint32_t c_simple_http_cpu_list_count(const char *list) {
+  uint32_t count = 0;
+  while (1) {
+    if (c_simple_http_internal_cpu_parse_entry(&list, NULL) != 0) {
+      return 0;
+    }
+    ++count;
+    if (*list == 0) {
+      return count;
+    }
+    ++list;
+  }
+}
+
+int c_simple_http_cpu_pin_worker(const Args *args,
+                                 uint32_t worker_idx,
+                                 const C_SIMPLE_HTTP_Listeners *listeners) {
+  if (!args->worker_cpus) {
+    return 0;
+  }
+
+  cpu_set_t set;
+  if (c_simple_http_internal_cpu_list_get(args->worker_cpus, worker_idx, &set)
+      != 0) {
+    fprintf(stderr,
+            "ERROR Invalid --worker-cpus=%s entry!\n",
+            args->worker_cpus);
+    return 1;
+  }
+  int ret = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set);
+  if (ret != 0) {
+    fprintf(stderr,
+            "ERROR Failed to pin worker %" PRIu32 " to its CPU(s)! "
+            "(error %d)\n",
+            worker_idx,
+            ret);
+    return 1;
+  }
+
+  int cpu = c_simple_http_internal_cpu_single(&set);
+  for (uint32_t idx = 0; cpu >= 0 && idx < listeners->count; ++idx) {
+    const C_SIMPLE_HTTP_Listener *listener = &listeners->listeners[idx];
+    if (listener->addr.ss_family == AF_UNIX || listener->fd < 0) {
+      continue;
+    }
+    if (setsockopt(listener->fd,
+                   SOL_SOCKET,
+                   SO_INCOMING_CPU,
+                   &cpu,
+                   sizeof(int)) != 0) {
+      fprintf(stderr,
+              "WARNING Failed to set SO_INCOMING_CPU on a listener! "
+              "(errno %d)\n",
+              errno);
+    }
+  }
+  return 0;
+}
+
+int c_simple_http_cpu_attach_reuseport_bpf(
+    const Args *args,
+    const C_SIMPLE_HTTP_Listeners *listeners) {
+  const uint32_t workers = args->workers == 0 ? 1 : args->workers;
+  // Loads the CPU, then for each pinned worker compares it and returns the
+  // worker's index on a match, falling back to "CPU % workers".
+  __attribute__((cleanup(simple_archiver_helper_cleanup_malloced)))
+  void *code_ptr = malloc(sizeof(struct sock_filter) * (3 + 2 * workers));
+  if (!code_ptr) {
+    return 1;
+  }
+  struct sock_filter *code = code_ptr;
+  uint16_t len = 0;
+  code[len++] = (struct sock_filter)BPF_STMT(
+    BPF_LD | BPF_W | BPF_ABS,
+    (uint32_t)(SKF_AD_OFF + SKF_AD_CPU));
+  for (uint32_t idx = 0; args->worker_cpus && idx < workers; ++idx) {
+    cpu_set_t set;
+    if (c_simple_http_internal_cpu_list_get(args->worker_cpus, idx, &set)
+        != 0) {
+      return 1;
+    }
+    const int cpu = c_simple_http_internal_cpu_single(&set);
+    if (cpu >= 0) {
+      code[len++] = (struct sock_filter)BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K,
+                                                 (uint32_t)cpu,
+                                                 0,
+                                                 1);
+      code[len++] = (struct sock_filter)BPF_STMT(BPF_RET | BPF_K, idx);
+    }
+  }
+  code[len++] = (struct sock_filter)BPF_STMT(BPF_ALU | BPF_MOD | BPF_K,
+                                             workers);
+  code[len++] = (struct sock_filter)BPF_STMT(BPF_RET | BPF_A, 0);
+  struct sock_fprog prog = {.len = len, .filter = code};
+
+  for (uint32_t idx = 0; idx < listeners->count; ++idx) {
+    const C_SIMPLE_HTTP_Listener *listener = &listeners->listeners[idx];
+    if (listener->addr.ss_family == AF_UNIX || listener->fd < 0) {
+      continue;
+    }
+    if (setsockopt(listener->fd,
+                   SOL_SOCKET,
+                   SO_ATTACH_REUSEPORT_CBPF,
+                   &prog,
+                   sizeof(struct sock_fprog)) != 0) {
+      fprintf(stderr,
+              "ERROR Failed to attach the SO_REUSEPORT BPF program! "
+              "(errno %d)\n",
+              errno);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// vim: et ts=2 sts=2 sw=2
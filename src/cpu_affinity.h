@@ -0,0 +1,55 @@
+// ISC License
+// 
+// Copyright (c) 2026 Stephen Seo
+// 
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef SEODISPARATE_COM_C_SIMPLE_HTTP_CPU_AFFINITY_H_
+#define SEODISPARATE_COM_C_SIMPLE_HTTP_CPU_AFFINITY_H_
+
+// Standard library includes.
+#include <stdint.h>
+
+// Local includes.
+#include "arg_parse.h"
+#include "listener.h"
+
+/// Validates a "--worker-cpus" list. Entries are separated by ',', and each
+/// is the CPU set of a worker: a CPU, or an inclusive range of CPUs
+/// "<FIRST>-<LAST>". Workers past the end of the list start over from its
+/// first entry.
+/// Returns the number of entries, or zero if the list is invalid.
+uint32_t c_simple_http_cpu_list_count(const char *list);
+
+/// Pins the calling thread to the "--worker-cpus" entry of worker
+/// "worker_idx" (the main thread's event loop is worker 0). If the entry is a
+/// single CPU, SO_INCOMING_CPU is set to it on the TCP "listeners".
+/// Does nothing if "--worker-cpus" was not given.
+/// Returns zero on success.
+int c_simple_http_cpu_pin_worker(const Args *args,
+                                 uint32_t worker_idx,
+                                 const C_SIMPLE_HTTP_Listeners *listeners);
+
+/// Attaches a classic BPF program (SO_ATTACH_REUSEPORT_CBPF) to the
+/// SO_REUSEPORT group of each TCP listener, which picks the socket of the
+/// worker pinned to the CPU that received the connection, or else socket
+/// "CPU % workers". The sockets must have joined their groups in worker
+/// order, as c_simple_http_workers_start() does.
+/// Returns zero on success.
+int c_simple_http_cpu_attach_reuseport_bpf(
+  const Args *args,
+  const C_SIMPLE_HTTP_Listeners *listeners);
+
+#endif
+
+// vim: et ts=2 sts=2 sw=2
@@ -0,0 +1,807 @@
+// ISC License
+// 
+// Copyright (c) 2026 Stephen Seo
+// 
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+// Required for accept4().
+#define _GNU_SOURCE
+
+#include "event_loop.h"
+
+// Standard library includes.
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+// Linux/Unix includes.
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/inotify.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <linux/limits.h>
+#include <unistd.h>
+#include <errno.h>
+
+// Third party includes.
+#include <SimpleArchiver/src/helpers.h>
+
+// Local includes.
+#include "config.h"
+#include "connection.h"
+#include "constants.h"
+#include "globals.h"
+#include "io_uring_backend.h"
+#include "upgrade.h"
+#include "workers.h"
+
+/// Returns zero if the config was reloaded.
+int c_simple_http_internal_reload_config(C_SIMPLE_HTTP_EventLoop *loop) {
+  C_SIMPLE_HTTP_ParsedConfig new_parsed_config = c_simple_http_parse_config(
+    loop->ctx->args->config_file,
+    "PATH",
+    NULL);
+  if (new_parsed_config.hash_map) {
+    if (loop->ctx->config_lock) {
+      pthread_rwlock_wrlock(loop->ctx->config_lock);
+    }
+    c_simple_http_clean_up_parsed_config(loop->ctx->parsed);
+    *loop->ctx->parsed = new_parsed_config;
+    if (loop->ctx->config_lock) {
+      pthread_rwlock_unlock(loop->ctx->config_lock);
+    }
+    return 0;
+  }
+
+  c_simple_http_clean_up_parsed_config(&new_parsed_config);
+  return 1;
+}
+
+void c_simple_http_internal_set_config_needs_reload(
+    C_SIMPLE_HTTP_EventLoop *loop) {
+  fprintf(
+    stderr,
+    "WARNING Failed to set listen on config, autoreloading later...\n");
+  loop->flags |= 1;
+  clock_gettime(CLOCK_MONOTONIC, &loop->config_try_reload_time);
+}
+
+int c_simple_http_event_loop_init(C_SIMPLE_HTTP_EventLoop *loop,
+                                  ConnectionContext *ctx,
+                                  C_SIMPLE_HTTP_Listeners *listeners,
+                                  int inotify_fd,
+                                  int wakeup_fd) {
+  memset(loop, 0, sizeof(C_SIMPLE_HTTP_EventLoop));
+  loop->listeners = listeners;
+  loop->inotify_fd = inotify_fd;
+  loop->wakeup_fd = wakeup_fd;
+  loop->ctx = ctx;
+  loop->epoll_fd = -1;
+  // Each worker's loop gets an equal share of the max connections.
+  const uint32_t workers = ctx->args->workers == 0 ? 1 : ctx->args->workers;
+  const uint32_t max_connections =
+    (ctx->args->max_connections + workers - 1) / workers;
+  if (c_simple_http_connection_pool_init(&loop->connections, max_connections)
+      != 0) {
+    fprintf(stderr, "ERROR Failed to allocate %" PRIu32 " connections!\n",
+            max_connections);
+    return 1;
+  }
+  loop->overload_connections =
+    (ctx->args->overload_connections + workers - 1) / workers;
+  if (ctx->args->overload_queued_bytes != 0) {
+    loop->overload_queued_bytes =
+      (ctx->args->overload_queued_bytes - 1) / workers + 1;
+  }
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  c_simple_http_timer_wheel_init(&loop->timers, &now);
+  ctx->timers = &loop->timers;
+
+  if ((ctx->args->flags & 0x10) != 0) {
+    // The io_uring backend sets itself up when it is run.
+    return 0;
+  }
+
+  loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (loop->epoll_fd < 0) {
+    fprintf(stderr,
+            "ERROR Failed to create epoll instance! (errno %d)\n",
+            errno);
+    return 1;
+  }
+
+  struct epoll_event event;
+  memset(&event, 0, sizeof(struct epoll_event));
+
+  for (uint32_t idx = 0; idx < listeners->count; ++idx) {
+    C_SIMPLE_HTTP_Listener *listener = &listeners->listeners[idx];
+    event.events = EPOLLIN | EPOLLET;
+    event.data.ptr = listener;
+    if (epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, listener->fd, &event) != 0) {
+      fprintf(stderr,
+              "ERROR Failed to add listen socket to epoll! (errno %d)\n",
+              errno);
+      return 1;
+    }
+  }
+
+  if (inotify_fd >= 0) {
+    event.events = EPOLLIN | EPOLLET;
+    event.data.ptr = &loop->inotify_fd;
+    if (epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, inotify_fd, &event) != 0) {
+      fprintf(stderr,
+              "ERROR Failed to add inotify fd to epoll! (errno %d)\n",
+              errno);
+      return 1;
+    }
+  }
+
+  if (wakeup_fd >= 0) {
+    // Level-triggered so that a pending wakeup is never missed.
+    event.events = EPOLLIN;
+    event.data.ptr = &loop->wakeup_fd;
+    if (epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, wakeup_fd, &event) != 0) {
+      fprintf(stderr,
+              "ERROR Failed to add wakeup fd to epoll! (errno %d)\n",
+              errno);
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+void c_simple_http_event_loop_cleanup(C_SIMPLE_HTTP_EventLoop *loop) {
+  if (loop) {
+    c_simple_http_connection_pool_cleanup(&loop->connections);
+    if (loop->epoll_fd >= 0) {
+      close(loop->epoll_fd);
+      loop->epoll_fd = -1;
+    }
+  }
+}
+
+/// Sends the 503 response to a new connection and closes it.
+void c_simple_http_internal_reject_connection(int connection_fd) {
+  static size_t response_size = 0;
+  const char *response = c_simple_http_response_code_error_to_response(
+    C_SIMPLE_HTTP_Response_503_Service_Unavailable);
+  if (response_size == 0) {
+    response_size = strlen(response);
+  }
+  // Best effort, the connection is closed regardless.
+  ssize_t ret = send(connection_fd,
+                     response,
+                     response_size,
+                     MSG_DONTWAIT | MSG_NOSIGNAL);
+  (void)ret;
+  close(connection_fd);
+}
+
+/// Enters or leaves the overloaded state from the loop's connection count and
+/// unsent bytes. Accepting is paused while overloaded, unless
+/// "--overload-reject" was given.
+void c_simple_http_internal_update_overload(C_SIMPLE_HTTP_EventLoop *loop) {
+  if ((loop->flags & 8) != 0
+      || (loop->overload_connections == 0
+        && loop->overload_queued_bytes == 0)) {
+    return;
+  }
+
+  const uint32_t count =
+    c_simple_http_connection_pool_count(&loop->connections);
+  const size_t queued = loop->connections.queued_bytes;
+  if ((loop->flags & 0x20) == 0) {
+    if ((loop->overload_connections == 0
+          || count < loop->overload_connections)
+        && (loop->overload_queued_bytes == 0
+          || queued < loop->overload_queued_bytes)) {
+      return;
+    }
+    loop->flags |= 0x20;
+    const int_fast8_t reject = (loop->ctx->args->flags & 0x40) != 0 ? 1 : 0;
+    fprintf(stderr,
+            "WARNING Overloaded with %" PRIu32 " connection(s) and %zu "
+            "unsent bytes, %s new connections...\n",
+            count,
+            queued,
+            reject ? "rejecting" : "not accepting");
+    if (!reject) {
+      loop->flags |= 0x40;
+      if (loop->io_uring) {
+        c_simple_http_io_uring_stop_accepting(loop);
+      }
+    }
+    return;
+  }
+
+  if ((loop->overload_connections != 0
+        && (uint64_t)count * 100 >= (uint64_t)loop->overload_connections
+                                    * C_SIMPLE_HTTP_OVERLOAD_RESUME_PERCENT)
+      || (loop->overload_queued_bytes != 0
+        && queued >= loop->overload_queued_bytes / 100
+                     * C_SIMPLE_HTTP_OVERLOAD_RESUME_PERCENT)) {
+    return;
+  }
+  fprintf(stderr, "NOTICE No longer overloaded, accepting connections...\n");
+  if ((loop->flags & 0x40) != 0) {
+    if (loop->io_uring) {
+      c_simple_http_io_uring_resume_accepting(loop);
+    } else {
+      for (uint32_t idx = 0; idx < loop->listeners->count; ++idx) {
+        if ((loop->listeners->listeners[idx].flags & 4) != 0) {
+          // Connections may have been left pending while not accepting.
+          loop->flags |= 4;
+        }
+      }
+    }
+  }
+  loop->flags &= ~(uint32_t)0x60;
+}
+
+ConnectionItem *c_simple_http_event_loop_add_connection(
+    C_SIMPLE_HTTP_EventLoop *loop,
+    int connection_fd,
+    const struct in6_addr *peer_addr) {
+  c_simple_http_internal_update_overload(loop);
+  if ((loop->flags & 0x20) != 0 && (loop->ctx->args->flags & 0x40) != 0) {
+    c_simple_http_internal_reject_connection(connection_fd);
+    return NULL;
+  }
+
+  ConnectionItem *citem = c_simple_http_connection_pool_acquire(
+    &loop->connections, connection_fd);
+  if (!citem) {
+    fprintf(stderr,
+            "WARNING Too many connections, rejecting new connection...\n");
+    c_simple_http_internal_reject_connection(connection_fd);
+    return NULL;
+  }
+
+  if ((loop->ctx->args->flags & 1) == 0) {
+    printf("Peer connected: addr is ");
+    c_simple_http_print_ipv6_addr(stdout, peer_addr);
+    printf(", fd is %d\n", connection_fd);
+  } else {
+    printf("Peer connected.\n");
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &citem->time_point);
+  citem->peer_addr = *peer_addr;
+  // The first request's headers are timed from the connection.
+  citem->flags |= 0x40;
+  citem->request_time = citem->time_point;
+  c_simple_http_timer_wheel_schedule(
+    &loop->timers,
+    &citem->timer,
+    &citem->time_point,
+    c_simple_http_connection_timeout_remaining(citem, loop->ctx));
+  return citem;
+}
+
+void c_simple_http_event_loop_remove_connection(C_SIMPLE_HTTP_EventLoop *loop,
+                                                ConnectionItem *citem) {
+  if (loop->epoll_fd >= 0 && citem->fd >= 0) {
+    // A forked child (xdg-mime) may still hold the fd, in which case closing
+    // it would not remove it from epoll, and its events would refer to a
+    // reused ConnectionItem.
+    epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, citem->fd, NULL);
+  }
+  c_simple_http_connection_pool_release(&loop->connections, citem);
+  if ((loop->flags & 0x80) != 0) {
+    // Accept the connections left pending by a failed accept.
+    loop->flags = (loop->flags & ~(uint32_t)0x80) | 4;
+  }
+}
+
+void c_simple_http_internal_accept_connections(
+    C_SIMPLE_HTTP_EventLoop *loop,
+    C_SIMPLE_HTTP_Listener *listener) {
+  struct sockaddr_storage peer_info;
+  struct in6_addr peer_addr;
+  socklen_t socket_len;
+  int ret;
+
+  // Edge-triggered, so accepting continues on the next iteration of the loop
+  // (after serving the other events) if the budget ran out before all pending
+  // connections were accepted.
+  listener->flags &= ~(uint32_t)4;
+  for (uint32_t accepted = 0; 1; ++accepted) {
+    if ((loop->flags & 0x40) != 0) {
+      // Overloaded, the pending connections are accepted later.
+      listener->flags |= 4;
+      break;
+    } else if (accepted >= loop->ctx->args->accept_budget) {
+      listener->flags |= 4;
+      loop->flags |= 4;
+      break;
+    }
+    socket_len = sizeof(struct sockaddr_storage);
+    ret = accept4(listener->fd,
+                  (struct sockaddr *)&peer_info,
+                  &socket_len,
+                  SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (ret == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      // No connecting peers, do nothing.
+      break;
+    } else if (ret == -1 && errno == EINTR) {
+      continue;
+    } else if (ret == -1 && (errno == ECONNABORTED || errno == EPROTO)) {
+      // The peer gave up before it was accepted, others may be pending.
+      continue;
+    } else if (ret == -1
+        && (errno == EMFILE || errno == ENFILE
+          || errno == ENOBUFS || errno == ENOMEM)) {
+      fprintf(stderr,
+              "WARNING Failed to accept connection (errno %d), retrying "
+              "later...\n",
+              errno);
+      // Retried once a connection is removed (and freed its fd), instead of
+      // busy looping until then.
+      listener->flags |= 4;
+      loop->flags |= 0x80;
+      break;
+    } else if (ret == -1) {
+      fprintf(stderr, "WARNING Failed to accept connection (errno %d)\n",
+              errno);
+      break;
+    } else if (ret >= 0) {
+      int connection_fd = ret;
+      c_simple_http_listener_peer_to_ipv6(&peer_info, &peer_addr);
+      ConnectionItem *citem = c_simple_http_event_loop_add_connection(
+        loop, connection_fd, &peer_addr);
+      if (!citem) {
+        continue;
+      }
+
+      struct epoll_event event;
+      memset(&event, 0, sizeof(struct epoll_event));
+      // Edge-triggered EPOLLOUT only wakes up the loop when a full send
+      // buffer becomes writable again, which resumes sending large responses.
+      event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+      event.data.ptr = citem;
+      if (epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, connection_fd, &event)
+          != 0) {
+        fprintf(stderr,
+                "ERROR Failed to add connection fd to epoll! (errno %d)\n",
+                errno);
+        c_simple_http_event_loop_remove_connection(loop, citem);
+        continue;
+      }
+    } else {
+      fprintf(stderr, "WARNING accept: Unknown invalid state!\n");
+      break;
+    }
+  }
+}
+
+void c_simple_http_event_loop_handle_inotify(C_SIMPLE_HTTP_EventLoop *loop) {
+  char inotify_event_buf[sizeof(struct inotify_event) + NAME_MAX + 1]
+    __attribute__((aligned(__alignof__(struct inotify_event))));
+  // xxxx xxx1 - config file modified.
+  // xxxx xx1x - config file watch removed (IN_IGNORED).
+  uint32_t modified = 0;
+
+  // Edge-triggered, so read until there are no more events.
+  while (1) {
+    ssize_t read_ret =
+      read(loop->inotify_fd, inotify_event_buf, sizeof(inotify_event_buf));
+    if (read_ret == -1) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        // No events, do nothing.
+      } else {
+        fprintf(
+          stderr,
+          "WARNING Error code \"%d\" on config file listen for hot "
+          "reloading!\n",
+          errno);
+      }
+      break;
+    } else if (read_ret <= 0) {
+      break;
+    }
+
+    for (size_t idx = 0; idx < (size_t)read_ret;) {
+      const struct inotify_event *inotify_event =
+        (const struct inotify_event *)(inotify_event_buf + idx);
+#ifndef NDEBUG
+      printf("DEBUG inotify_event->mask: %" PRIx32 "\n", inotify_event->mask);
+#endif
+      if ((inotify_event->mask & IN_MODIFY) != 0
+          || (inotify_event->mask & IN_CLOSE_WRITE) != 0) {
+        modified |= 1;
+      } else if ((inotify_event->mask & IN_IGNORED) != 0) {
+        modified |= 2;
+      }
+      idx += sizeof(struct inotify_event) + inotify_event->len;
+    }
+  }
+
+  if (modified == 0) {
+    return;
+  } else if ((modified & 2) != 0) {
+    fprintf(stderr, "NOTICE Config file modified (IN_IGNORED), reloading...\n");
+  } else {
+    fprintf(stderr, "NOTICE Config file modified, reloading...\n");
+  }
+
+  if (c_simple_http_internal_reload_config(loop) != 0) {
+    fprintf(stderr, "WARNING New config is invalid, keeping old config...\n");
+  }
+
+  if ((modified & 2) != 0) {
+    // The watch was removed, so it must be re-added.
+    if (inotify_add_watch(
+        loop->inotify_fd,
+        loop->ctx->args->config_file,
+        IN_MODIFY | IN_CLOSE_WRITE) == -1) {
+      c_simple_http_internal_set_config_needs_reload(loop);
+    }
+  }
+}
+
+/// Returns zero on success, non-zero if the program should stop.
+int c_simple_http_internal_try_config_reload(C_SIMPLE_HTTP_EventLoop *loop) {
+  const struct timespec *current_time = &loop->ctx->current_time;
+  if ((loop->flags & 1) == 0
+      || c_simple_http_helper_timespec_diff_millis(
+           &loop->config_try_reload_time, current_time)
+         < C_SIMPLE_HTTP_TRY_CONFIG_RELOAD_MILLIS) {
+    return 0;
+  }
+
+  loop->config_try_reload_time = *current_time;
+  ++loop->config_try_reload_attempts;
+  fprintf(
+    stderr,
+    "Attempting to reload config now (try %" PRIu32 " of %u)...\n",
+    loop->config_try_reload_attempts,
+    C_SIMPLE_HTTP_TRY_CONFIG_RELOAD_MAX_ATTEMPTS);
+  if (c_simple_http_internal_reload_config(loop) == 0) {
+    loop->flags &= 0xFFFFFFFE;
+    fprintf(stderr, "Reloaded config.\n");
+    if (inotify_add_watch(
+        loop->inotify_fd,
+        loop->ctx->args->config_file,
+        IN_MODIFY | IN_CLOSE_WRITE) == -1) {
+      c_simple_http_internal_set_config_needs_reload(loop);
+    } else {
+      loop->config_try_reload_attempts = 0;
+    }
+  } else if (loop->config_try_reload_attempts
+      >= C_SIMPLE_HTTP_TRY_CONFIG_RELOAD_MAX_ATTEMPTS) {
+    fprintf(stderr, "ERROR Attempted to reload config too many times,"
+      " stopping!\n");
+    return 1;
+  }
+
+  return 0;
+}
+
+void c_simple_http_event_loop_handle_wakeup(C_SIMPLE_HTTP_EventLoop *loop) {
+  uint64_t value;
+  ssize_t ret = read(loop->wakeup_fd, &value, sizeof(uint64_t));
+  (void)ret;
+}
+
+void c_simple_http_internal_connection_timer_expired(
+    C_SIMPLE_HTTP_TimerEntry *entry,
+    void *ud) {
+  C_SIMPLE_HTTP_EventLoop *loop = ud;
+  ConnectionItem *citem = (ConnectionItem *)
+    ((char *)entry - offsetof(ConnectionItem, timer));
+
+  // Activity moves "time_point" forward without rescheduling the timer, so
+  // it is only rescheduled here.
+  int64_t remaining = c_simple_http_connection_timeout_remaining(citem,
+                                                                 loop->ctx);
+  if (remaining > 0) {
+    c_simple_http_timer_wheel_schedule(&loop->timers,
+                                       entry,
+                                       &loop->ctx->current_time,
+                                       remaining);
+    return;
+  }
+
+  if ((citem->flags & 4) == 0) {
+    fprintf(stderr, "Peer ");
+    c_simple_http_print_ipv6_addr(stderr, &citem->peer_addr);
+    fprintf(stderr, " timed out.\n");
+  }
+  if (loop->io_uring) {
+    // io_uring may still reference the connection, so it is removed only
+    // after its pending operations are done. A closing connection also ends
+    // up here if its send stalled.
+    c_simple_http_io_uring_abort_connection(loop, citem);
+    // Kept armed until the close completes, in case the send could not be
+    // cancelled yet.
+    c_simple_http_timer_wheel_schedule(&loop->timers,
+                                       entry,
+                                       &loop->ctx->current_time,
+                                       C_SIMPLE_HTTP_ABORT_RETRY_MILLIS);
+  } else {
+    c_simple_http_event_loop_remove_connection(loop, citem);
+  }
+}
+
+int c_simple_http_event_loop_next_timeout(const C_SIMPLE_HTTP_EventLoop *loop) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  if ((loop->flags & 4) != 0) {
+    // More connections are pending after the last accept budget.
+    return 0;
+  }
+
+  int64_t timeout = c_simple_http_timer_wheel_next_timeout(&loop->timers,
+                                                          &now);
+  int64_t remaining;
+  if ((loop->flags & 8) != 0) {
+    remaining = (int64_t)loop->ctx->args->drain_timeout_seconds * 1000
+      - c_simple_http_helper_timespec_diff_millis(&loop->drain_time, &now);
+    if (remaining < 0) {
+      remaining = 0;
+    }
+    if (timeout < 0 || remaining < timeout) {
+      timeout = remaining;
+    }
+  } else if (C_SIMPLE_HTTP_DRAINING) {
+    // Draining starts in c_simple_http_event_loop_do_tasks().
+    return 0;
+  }
+  if ((loop->flags & 1) != 0) {
+    remaining = C_SIMPLE_HTTP_TRY_CONFIG_RELOAD_MILLIS
+      - c_simple_http_helper_timespec_diff_millis(
+          &loop->config_try_reload_time, &now);
+    if (remaining < 0) {
+      remaining = 0;
+    }
+    if (timeout < 0 || remaining < timeout) {
+      timeout = remaining;
+    }
+  }
+
+  return (int)timeout;
+}
+
+/// Passes the listeners of all loops on to a new process.
+/// Returns zero on success.
+int c_simple_http_internal_hot_upgrade(C_SIMPLE_HTTP_EventLoop *loop) {
+  if (!loop->argv) {
+    return 1;
+  }
+
+  uint32_t worker_count = loop->workers ? loop->workers->count : 0;
+  __attribute__((cleanup(simple_archiver_helper_cleanup_malloced)))
+  void *fds_ptr = malloc(sizeof(int)
+                         * C_SIMPLE_HTTP_LISTENERS_MAX
+                         * (worker_count + 1));
+  if (!fds_ptr) {
+    return 1;
+  }
+  int *fds = fds_ptr;
+  uint32_t fd_count = 0;
+  for (uint32_t idx = 0; idx <= worker_count; ++idx) {
+    const C_SIMPLE_HTTP_Listeners *listeners = idx == 0
+      ? loop->listeners
+      : &loop->workers->workers[idx - 1].listeners;
+    for (uint32_t l_idx = 0; l_idx < listeners->count; ++l_idx) {
+      // Shared unix sockets are only passed on once.
+      if ((listeners->listeners[l_idx].flags & 1) != 0) {
+        fds[fd_count++] = listeners->listeners[l_idx].fd;
+      }
+    }
+  }
+
+  if (c_simple_http_upgrade_spawn(loop->argv, fds, fd_count) != 0) {
+    return 1;
+  }
+
+  // The unix socket files are now the new process' to remove.
+  for (uint32_t idx = 0; idx < loop->listeners->count; ++idx) {
+    loop->listeners->listeners[idx].flags &= ~(uint32_t)2;
+  }
+  return 0;
+}
+
+/// Stops accepting connections. Draining ends once all connections are done.
+void c_simple_http_internal_start_drain(C_SIMPLE_HTTP_EventLoop *loop) {
+  loop->flags |= 8;
+  loop->flags &= ~(uint32_t)4;
+  loop->drain_time = loop->ctx->current_time;
+  if (loop->workers) {
+    c_simple_http_workers_wakeup(loop->workers);
+  }
+
+  if (loop->io_uring) {
+    c_simple_http_io_uring_stop_accepting(loop);
+  } else {
+    for (uint32_t idx = 0; idx < loop->listeners->count; ++idx) {
+      C_SIMPLE_HTTP_Listener *listener = &loop->listeners->listeners[idx];
+      epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, listener->fd, NULL);
+      listener->flags &= ~(uint32_t)4;
+    }
+  }
+
+  // New connections are refused from now on, unless a new process (SIGUSR2)
+  // has the same sockets. Unix sockets may be shared with the workers, so
+  // only their files are removed.
+  for (uint32_t idx = 0; idx < loop->listeners->count; ++idx) {
+    C_SIMPLE_HTTP_Listener *listener = &loop->listeners->listeners[idx];
+    if (listener->addr.ss_family == AF_UNIX) {
+      if ((listener->flags & 2) != 0) {
+        unlink(((const struct sockaddr_un *)&listener->addr)->sun_path);
+        listener->flags &= ~(uint32_t)2;
+      }
+    } else if ((listener->flags & 1) != 0) {
+      close(listener->fd);
+      listener->fd = -1;
+      listener->flags &= ~(uint32_t)1;
+    }
+  }
+}
+
+/// Closes the connections that are waiting for another keep-alive request.
+/// New connections are left to send their first request.
+void c_simple_http_internal_close_idle(C_SIMPLE_HTTP_EventLoop *loop) {
+  for (uint32_t idx = 0; idx < loop->connections.capacity; ++idx) {
+    ConnectionItem *citem = &loop->connections.items[idx];
+    if (citem->fd < 0 || citem->request_count == 0
+        || (citem->flags & 0xE) != 0 || citem->in.size != 0
+        || citem->out.size != 0) {
+      continue;
+    }
+    if (loop->io_uring) {
+      c_simple_http_io_uring_close_connection(loop, citem);
+    } else {
+      c_simple_http_event_loop_remove_connection(loop, citem);
+    }
+  }
+}
+
+int c_simple_http_event_loop_do_tasks(C_SIMPLE_HTTP_EventLoop *loop) {
+  ConnectionContext *ctx = loop->ctx;
+
+  if ((loop->flags & 2) == 0 && C_SIMPLE_HTTP_SIGUSR1_SET) {
+    // Handle hot-reloading of config file due to SIGUSR1.
+    C_SIMPLE_HTTP_SIGUSR1_SET = 0;
+    fprintf(stderr, "NOTICE SIGUSR1, reloading config file...\n");
+    if (c_simple_http_internal_reload_config(loop) != 0) {
+      fprintf(
+        stderr, "WARNING New config is invalid, keeping old config...\n");
+    }
+  }
+
+  if ((loop->flags & 2) == 0 && C_SIMPLE_HTTP_SIGUSR2_SET) {
+    C_SIMPLE_HTTP_SIGUSR2_SET = 0;
+    if (C_SIMPLE_HTTP_DRAINING) {
+      fprintf(stderr, "WARNING SIGUSR2 while draining, ignoring...\n");
+    } else {
+      fprintf(stderr,
+              "NOTICE SIGUSR2, passing listeners on to a new process...\n");
+      if (c_simple_http_internal_hot_upgrade(loop) == 0) {
+        C_SIMPLE_HTTP_DRAINING = 1;
+      } else {
+        fprintf(stderr, "WARNING Failed to start new process, continuing...\n");
+      }
+    }
+  }
+
+  if (c_simple_http_internal_try_config_reload(loop) != 0) {
+    return 6;
+  }
+
+  if (C_SIMPLE_HTTP_DRAINING) {
+    if ((loop->flags & 8) == 0) {
+      c_simple_http_internal_start_drain(loop);
+    }
+    c_simple_http_internal_close_idle(loop);
+
+    const uint32_t count =
+      c_simple_http_connection_pool_count(&loop->connections);
+    if (count != 0 && (loop->flags & 0x10) == 0
+        && c_simple_http_helper_timespec_diff_millis(&loop->drain_time,
+                                                     &ctx->current_time)
+           >= (int64_t)ctx->args->drain_timeout_seconds * 1000) {
+      if (ctx->args->drain_timeout_seconds != 0) {
+        fprintf(stderr,
+                "WARNING Drain timed out, closing %" PRIu32
+                " connection(s)...\n",
+                count);
+      }
+      loop->flags |= 0x10;
+    }
+  }
+
+  c_simple_http_timer_wheel_expire(
+    &loop->timers,
+    &ctx->current_time,
+    c_simple_http_internal_connection_timer_expired,
+    loop);
+
+  c_simple_http_internal_update_overload(loop);
+
+  return 0;
+}
+
+int c_simple_http_event_loop_drained(const C_SIMPLE_HTTP_EventLoop *loop) {
+  return (loop->flags & 8) != 0
+    && ((loop->flags & 0x10) != 0
+      || c_simple_http_connection_pool_count(&loop->connections) == 0);
+}
+
+int c_simple_http_event_loop_run(C_SIMPLE_HTTP_EventLoop *loop) {
+  if ((loop->ctx->args->flags & 0x10) != 0) {
+    return c_simple_http_io_uring_run(loop);
+  }
+
+  struct epoll_event events[C_SIMPLE_HTTP_EPOLL_MAX_EVENTS];
+  ConnectionContext *ctx = loop->ctx;
+
+  while (C_SIMPLE_HTTP_KEEP_RUNNING
+      && !c_simple_http_event_loop_drained(loop)) {
+    int count = epoll_wait(loop->epoll_fd,
+                           events,
+                           C_SIMPLE_HTTP_EPOLL_MAX_EVENTS,
+                           c_simple_http_event_loop_next_timeout(loop));
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      fprintf(stderr, "ERROR epoll_wait failed! (errno %d)\n", errno);
+      return 1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &ctx->current_time);
+
+    C_SIMPLE_HTTP_Listener *listeners_begin = loop->listeners->listeners;
+    C_SIMPLE_HTTP_Listener *listeners_end =
+      listeners_begin + loop->listeners->count;
+    for (int idx = 0; idx < count; ++idx) {
+      void *ptr = events[idx].data.ptr;
+      if ((C_SIMPLE_HTTP_Listener *)ptr >= listeners_begin
+          && (C_SIMPLE_HTTP_Listener *)ptr < listeners_end) {
+        ((C_SIMPLE_HTTP_Listener *)ptr)->flags |= 4;
+      } else if (ptr == &loop->inotify_fd) {
+        c_simple_http_event_loop_handle_inotify(loop);
+      } else if (ptr == &loop->wakeup_fd) {
+        c_simple_http_event_loop_handle_wakeup(loop);
+      } else if (c_simple_http_manage_connections(ptr, ctx)) {
+        c_simple_http_event_loop_remove_connection(loop, ptr);
+      }
+    }
+    // Existing connections are served before new ones are accepted. This
+    // includes connections left over from the last accept budget.
+    loop->flags &= ~(uint32_t)4;
+    for (C_SIMPLE_HTTP_Listener *listener = listeners_begin;
+        listener != listeners_end;
+        ++listener) {
+      if ((listener->flags & 4) != 0) {
+        c_simple_http_internal_accept_connections(loop, listener);
+      }
+    }
+
+    int ret = c_simple_http_event_loop_do_tasks(loop);
+    if (ret != 0) {
+      return ret;
+    }
+  }
+
+  return 0;
+}
+
+// vim: et ts=2 sts=2 sw=2
@@ -0,0 +1,135 @@
+// ISC License
+// 
+// Copyright (c) 2026 Stephen Seo
+// 
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef SEODISPARATE_COM_C_SIMPLE_HTTP_EVENT_LOOP_H_
+#define SEODISPARATE_COM_C_SIMPLE_HTTP_EVENT_LOOP_H_
+
+// Standard library includes.
+#include <stdint.h>
+
+// Linux/Unix includes.
+#include <time.h>
+#include <netinet/in.h>
+
+// Local includes.
+#include "connection.h"
+#include "connection_pool.h"
+#include "helpers.h"
+#include "listener.h"
+#include "timer_wheel.h"
+
+typedef struct C_SIMPLE_HTTP_EventLoop {
+  int epoll_fd;
+  // Not owned by the loop.
+  C_SIMPLE_HTTP_Listeners *listeners;
+  // Is -1 if not listening on the config file for changes.
+  int inotify_fd;
+  // Written to (eventfd) to wake up the loop. May be -1.
+  int wakeup_fd;
+  // xxxx xxx1 - config needs to be reloaded.
+  // xxxx xx1x - is a worker thread's loop, SIGUSR1 and SIGUSR2 are left to
+  //             the main loop.
+  // xxxx x1xx - accept budget ran out on a listener, connections may still be
+  //             pending.
+  // xxxx 1xxx - draining, no longer accepting connections.
+  // xxx1 xxxx - drain timeout passed, the remaining connections are closed.
+  // xx1x xxxx - overloaded, see "overload_connections".
+  // x1xx xxxx - not accepting because overloaded.
+  // 1xxx xxxx - accepting failed for lack of fds or memory, retried once a
+  //             connection is removed.
+  uint32_t flags;
+  uint32_t config_try_reload_attempts;
+  struct timespec config_try_reload_time;
+  // When draining started.
+  struct timespec drain_time;
+  // Connection timeouts.
+  C_SIMPLE_HTTP_TimerWheel timers;
+  // Holds at most this loop's share of "--max-connections".
+  C_SIMPLE_HTTP_ConnectionPool connections;
+  // This loop's share of the "--overload-..." high-water marks, 0 if not set.
+  uint32_t overload_connections;
+  size_t overload_queued_bytes;
+  ConnectionContext *ctx;
+  // Non-NULL while the io_uring backend is running.
+  struct C_SIMPLE_HTTP_IOUring *io_uring;
+  // Set on the main loop only. The workers are woken up when draining starts,
+  // and their listeners are passed on with SIGUSR2.
+  struct C_SIMPLE_HTTP_Workers *workers;
+  // Set on the main loop only. The program's arguments, used to start the new
+  // process on SIGUSR2.
+  char **argv;
+} C_SIMPLE_HTTP_EventLoop;
+
+/// Sets up the event loop watching the given listeners and fds. "inotify_fd"
+/// and "wakeup_fd" may be -1.
+/// Unless the io_uring backend is selected, an epoll instance is created.
+/// Returns zero on success.
+int c_simple_http_event_loop_init(C_SIMPLE_HTTP_EventLoop *loop,
+                                  ConnectionContext *ctx,
+                                  C_SIMPLE_HTTP_Listeners *listeners,
+                                  int inotify_fd,
+                                  int wakeup_fd);
+
+/// Closes all connections and the epoll instance. The listeners and the
+/// inotify fd are not closed.
+void c_simple_http_event_loop_cleanup(C_SIMPLE_HTTP_EventLoop *loop);
+
+/// Waits on and handles events until C_SIMPLE_HTTP_KEEP_RUNNING is cleared,
+/// or until the loop has no more connections after C_SIMPLE_HTTP_DRAINING was
+/// set.
+/// Returns zero on normal exit, and non-zero if the program should exit with
+/// that error code.
+int c_simple_http_event_loop_run(C_SIMPLE_HTTP_EventLoop *loop);
+
+// The following are shared between the epoll and io_uring backends.
+
+/// Takes a ConnectionItem from the loop's pool for a newly accepted
+/// connection. If the pool is exhausted, or if the loop is overloaded with
+/// "--overload-reject", a 503 response is sent and the connection is closed,
+/// and NULL is returned.
+ConnectionItem *c_simple_http_event_loop_add_connection(
+  C_SIMPLE_HTTP_EventLoop *loop,
+  int connection_fd,
+  const struct in6_addr *peer_addr);
+
+/// Closes the connection and returns its ConnectionItem to the loop's pool.
+void c_simple_http_event_loop_remove_connection(C_SIMPLE_HTTP_EventLoop *loop,
+                                                ConnectionItem *citem);
+
+/// Reads all pending events from the inotify fd and reloads the config if
+/// necessary.
+void c_simple_http_event_loop_handle_inotify(C_SIMPLE_HTTP_EventLoop *loop);
+
+/// Drains the loop's wakeup fd.
+void c_simple_http_event_loop_handle_wakeup(C_SIMPLE_HTTP_EventLoop *loop);
+
+/// Returns the time in milliseconds until c_simple_http_event_loop_do_tasks()
+/// has work to do, or -1 if there are no pending timed tasks.
+int c_simple_http_event_loop_next_timeout(const C_SIMPLE_HTTP_EventLoop *loop);
+
+/// Handles SIGUSR1, SIGUSR2, config reload retries, draining, overload, and
+/// connection timeouts. Should be called after each wakeup with
+/// "loop->ctx->current_time" updated.
+/// Returns non-zero if the program should exit with that error code.
+int c_simple_http_event_loop_do_tasks(C_SIMPLE_HTTP_EventLoop *loop);
+
+/// Returns non-zero if the loop is draining and all its connections are done,
+/// or if the drain timeout passed.
+int c_simple_http_event_loop_drained(const C_SIMPLE_HTTP_EventLoop *loop);
+
+#endif
+
+// vim: et ts=2 sts=2 sw=2
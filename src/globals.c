@@ -18,5 +18,8 @@
 
 volatile int_fast8_t C_SIMPLE_HTTP_KEEP_RUNNING = 1;
 volatile int_fast8_t C_SIMPLE_HTTP_SIGUSR1_SET = 0;
+volatile int_fast8_t C_SIMPLE_HTTP_SIGUSR2_SET = 0;
+volatile int_fast8_t C_SIMPLE_HTTP_DRAINING = 0;
+int C_SIMPLE_HTTP_WAKEUP_FD = -1;
 
 // vim: et ts=2 sts=2 sw=2
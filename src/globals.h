@@ -22,6 +22,13 @@
 
 extern volatile int_fast8_t C_SIMPLE_HTTP_KEEP_RUNNING;
 extern volatile int_fast8_t C_SIMPLE_HTTP_SIGUSR1_SET;
+extern volatile int_fast8_t C_SIMPLE_HTTP_SIGUSR2_SET;
+// Set once the event loops should stop accepting and exit when their
+// connections are done.
+extern volatile int_fast8_t C_SIMPLE_HTTP_DRAINING;
+// An eventfd written to by the signal handlers to wake up the event loop.
+// Is -1 if not initialized.
+extern int C_SIMPLE_HTTP_WAKEUP_FD;
 
 #endif
 
@@ -0,0 +1,149 @@
+// ISC License
+// 
+// Copyright (c) 2026 Stephen Seo
+// 
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+#include "header_scan.h"
+
+// Standard library includes.
+#include <stdint.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define C_SIMPLE_HTTP_HEADER_SCAN_X86
+#include <immintrin.h>
+#endif
+
+typedef size_t (*C_SIMPLE_HTTP_HeaderScanFn)(const char *,
+                                             size_t,
+                                             char,
+                                             char);
+
+size_t c_simple_http_internal_header_scan_scalar(const char *buf,
+                                                 size_t size,
+                                                 char first,
+                                                 char second) {
+  size_t idx = 0;
+  for (; idx < size && buf[idx] != first && buf[idx] != second; ++idx) {
+  }
+  return idx;
+}
+
+#ifdef C_SIMPLE_HTTP_HEADER_SCAN_X86
+// SSE2 is always available on x86_64, and its byte compares are all that is
+// needed to match two bytes, so SSE4.2's string instructions are not used.
+size_t c_simple_http_internal_header_scan_sse2(const char *buf,
+                                               size_t size,
+                                               char first,
+                                               char second) {
+  const __m128i first_v = _mm_set1_epi8(first);
+  const __m128i second_v = _mm_set1_epi8(second);
+  size_t idx = 0;
+  for (; idx + 16 <= size; idx += 16) {
+    const __m128i chunk = _mm_loadu_si128((const __m128i *)(buf + idx));
+    const uint32_t mask = (uint32_t)_mm_movemask_epi8(
+      _mm_or_si128(_mm_cmpeq_epi8(chunk, first_v),
+                   _mm_cmpeq_epi8(chunk, second_v)));
+    if (mask != 0) {
+      return idx + (size_t)__builtin_ctz(mask);
+    }
+  }
+  return idx + c_simple_http_internal_header_scan_scalar(buf + idx,
+                                                         size - idx,
+                                                         first,
+                                                         second);
+}
+
+__attribute__((target("avx2")))
+size_t c_simple_http_internal_header_scan_avx2(const char *buf,
+                                               size_t size,
+                                               char first,
+                                               char second) {
+  const __m256i first_v = _mm256_set1_epi8(first);
+  const __m256i second_v = _mm256_set1_epi8(second);
+  size_t idx = 0;
+  for (; idx + 32 <= size; idx += 32) {
+    const __m256i chunk = _mm256_loadu_si256((const __m256i *)(buf + idx));
+    const uint32_t mask = (uint32_t)_mm256_movemask_epi8(
+      _mm256_or_si256(_mm256_cmpeq_epi8(chunk, first_v),
+                      _mm256_cmpeq_epi8(chunk, second_v)));
+    if (mask != 0) {
+      return idx + (size_t)__builtin_ctz(mask);
+    }
+  }
+  // Header lines are mostly short, so the rest is still worth a 16 byte step.
+  // It is done here rather than by calling the SSE2 kernel, as switching from
+  // AVX to non-VEX SSE code is slow on some CPUs.
+  if (idx + 16 <= size) {
+    const __m128i chunk = _mm_loadu_si128((const __m128i *)(buf + idx));
+    const uint32_t mask = (uint32_t)_mm_movemask_epi8(
+      _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm256_castsi256_si128(first_v)),
+                   _mm_cmpeq_epi8(chunk, _mm256_castsi256_si128(second_v))));
+    if (mask != 0) {
+      return idx + (size_t)__builtin_ctz(mask);
+    }
+    idx += 16;
+  }
+  for (; idx < size && buf[idx] != first && buf[idx] != second; ++idx) {
+  }
+  return idx;
+}
+#endif
+
+static C_SIMPLE_HTTP_HeaderScanFn c_simple_http_header_scan_fn =
+  c_simple_http_internal_header_scan_scalar;
+static enum C_SIMPLE_HTTP_HeaderScanKernel c_simple_http_header_scan_selected =
+  C_SIMPLE_HTTP_HeaderScan_Scalar;
+
+void c_simple_http_header_scan_init(void) {
+  if (c_simple_http_header_scan_use(C_SIMPLE_HTTP_HeaderScan_AVX2) != 0
+      && c_simple_http_header_scan_use(C_SIMPLE_HTTP_HeaderScan_SSE2) != 0) {
+    c_simple_http_header_scan_use(C_SIMPLE_HTTP_HeaderScan_Scalar);
+  }
+}
+
+int c_simple_http_header_scan_use(enum C_SIMPLE_HTTP_HeaderScanKernel kernel) {
+  switch (kernel) {
+    case C_SIMPLE_HTTP_HeaderScan_Scalar:
+      c_simple_http_header_scan_fn = c_simple_http_internal_header_scan_scalar;
+      break;
+#ifdef C_SIMPLE_HTTP_HEADER_SCAN_X86
+    case C_SIMPLE_HTTP_HeaderScan_SSE2:
+      c_simple_http_header_scan_fn = c_simple_http_internal_header_scan_sse2;
+      break;
+    case C_SIMPLE_HTTP_HeaderScan_AVX2:
+      __builtin_cpu_init();
+      if (!__builtin_cpu_supports("avx2")) {
+        return 1;
+      }
+      c_simple_http_header_scan_fn = c_simple_http_internal_header_scan_avx2;
+      break;
+#endif
+    default:
+      return 1;
+  }
+  c_simple_http_header_scan_selected = kernel;
+  return 0;
+}
+
+enum C_SIMPLE_HTTP_HeaderScanKernel c_simple_http_header_scan_kernel(void) {
+  return c_simple_http_header_scan_selected;
+}
+
+size_t c_simple_http_header_scan_find(const char *buf,
+                                      size_t size,
+                                      char first,
+                                      char second) {
+  return c_simple_http_header_scan_fn(buf, size, first, second);
+}
+
+// vim: et ts=2 sts=2 sw=2
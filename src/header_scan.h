@@ -0,0 +1,49 @@
+// ISC License
+// 
+// Copyright (c) 2026 Stephen Seo
+// 
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+#ifndef SEODISPARATE_COM_C_SIMPLE_HTTP_HEADER_SCAN_H_
+#define SEODISPARATE_COM_C_SIMPLE_HTTP_HEADER_SCAN_H_
+
+// Standard library includes.
+#include <stddef.h>
+
+enum C_SIMPLE_HTTP_HeaderScanKernel {
+  C_SIMPLE_HTTP_HeaderScan_Scalar,
+  C_SIMPLE_HTTP_HeaderScan_SSE2,
+  C_SIMPLE_HTTP_HeaderScan_AVX2,
+};
+
+/// Selects the fastest kernel for c_simple_http_header_scan_find that the CPU
+/// supports. Until this is called, the scalar kernel is used.
+/// Must be called before other threads may parse requests.
+void c_simple_http_header_scan_init(void);
+
+/// Selects "kernel" for c_simple_http_header_scan_find.
+/// Returns zero on success, or non-zero if the CPU (or the build) does not
+/// support it.
+int c_simple_http_header_scan_use(enum C_SIMPLE_HTTP_HeaderScanKernel kernel);
+
+enum C_SIMPLE_HTTP_HeaderScanKernel c_simple_http_header_scan_kernel(void);
+
+/// Returns the index of the first byte of "buf" that is "first" or "second",
+/// or "size" if there is none.
+size_t c_simple_http_header_scan_find(const char *buf,
+                                      size_t size,
+                                      char first,
+                                      char second);
+
+#endif
+
+// vim: et ts=2 sts=2 sw=2
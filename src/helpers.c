@@ -206,52 +206,6 @@ char c_simple_http_helper_hex_to_value(const char upper, const char lower) {
   return result;
 }
 
-char *c_simple_http_helper_unescape_uri(const char *uri) {
-  __attribute__((cleanup(simple_archiver_list_free)))
-  SDArchiverLinkedList *parts = simple_archiver_list_init();
-
-  const size_t size = strlen(uri);
-  size_t idx = 0;
-  size_t prev_idx = 0;
-  size_t buf_size;
-  char *buf;
-
-  for (; idx <= size; ++idx) {
-    if (uri[idx] == '%' && idx + 2 < size) {
-      if (idx > prev_idx) {
-        buf_size = idx - prev_idx + 1;
-        buf = malloc(buf_size);
-        memcpy(buf, uri + prev_idx, buf_size - 1);
-        buf[buf_size - 1] = 0;
-        c_simple_http_add_string_part(parts, buf, 0);
-        free(buf);
-      }
-      buf = malloc(2);
-      buf[0] = c_simple_http_helper_hex_to_value(uri[idx + 1], uri[idx + 2]);
-      buf[1] = 0;
-      if (buf[0] == 0) {
-        free(buf);
-        return NULL;
-      }
-      c_simple_http_add_string_part(parts, buf, 0);
-      free(buf);
-      prev_idx = idx + 3;
-      idx += 2;
-    }
-  }
-
-  if (idx > prev_idx) {
-    buf_size = idx - prev_idx + 1;
-    buf = malloc(buf_size);
-    memcpy(buf, uri + prev_idx, buf_size - 1);
-    buf[buf_size - 1] = 0;
-    c_simple_http_add_string_part(parts, buf, 0);
-    free(buf);
-  }
-
-  return c_simple_http_combine_string_parts(parts);
-}
-
 int c_simple_http_helper_mkdir_tree(const char *path) {
   // Check if dir already exists.
   DIR *dir_ptr = opendir(path);
@@ -337,6 +291,46 @@ char *c_simple_http_FILE_to_c_str(const char *filename, uint64_t *size_out) {
   return buf;
 }
 
+int c_simple_http_buffer_append(C_SIMPLE_HTTP_Buffer *buffer,
+                                const void *data,
+                                size_t size) {
+  if (buffer->size + size > buffer->capacity) {
+    size_t new_capacity = buffer->capacity == 0 ? 256 : buffer->capacity;
+    while (new_capacity < buffer->size + size) {
+      new_capacity *= 2;
+    }
+    char *new_buf = realloc(buffer->buf, new_capacity);
+    if (!new_buf) {
+      return 1;
+    }
+    buffer->buf = new_buf;
+    buffer->capacity = new_capacity;
+  }
+
+  if (size > 0) {
+    memcpy(buffer->buf + buffer->size, data, size);
+    buffer->size += size;
+  }
+  return 0;
+}
+
+void c_simple_http_buffer_cleanup(C_SIMPLE_HTTP_Buffer *buffer) {
+  if (buffer) {
+    if (buffer->buf) {
+      free(buffer->buf);
+    }
+    buffer->buf = NULL;
+    buffer->size = 0;
+    buffer->capacity = 0;
+  }
+}
+
+int64_t c_simple_http_helper_timespec_diff_millis(const struct timespec *from,
+                                                  const struct timespec *to) {
+  return (int64_t)(to->tv_sec - from->tv_sec) * 1000
+    + (int64_t)(to->tv_nsec - from->tv_nsec) / 1000000;
+}
+
 size_t c_simple_http_trim_end_whitespace(char *c_str) {
   size_t trimmed = 0;
 
@@ -24,6 +24,7 @@
 // libc includes.
 #include <time.h>
 #include <dirent.h>
+#include <pthread.h>
 
 // Local includes.
 #include "config.h"
@@ -36,6 +37,12 @@ typedef struct ConnectionContext {
   char *buf;
   const Args *args;
   C_SIMPLE_HTTP_ParsedConfig *parsed;
+  // Guards "parsed", which is shared by all worker threads.
+  pthread_rwlock_t *config_lock;
+  // Shared by all worker threads, NULL if "--rate-limit" is not set.
+  struct C_SIMPLE_HTTP_RateLimiter *rate_limiter;
+  // The connection timeouts of this thread's event loop. May be NULL.
+  struct C_SIMPLE_HTTP_TimerWheel *timers;
   struct timespec current_time;
 } ConnectionContext;
 
@@ -45,6 +52,12 @@ typedef struct C_SIMPLE_HTTP_String_Part {
   uintptr_t extra;
 } C_SIMPLE_HTTP_String_Part;
 
+typedef struct C_SIMPLE_HTTP_Buffer {
+  char *buf;
+  size_t size;
+  size_t capacity;
+} C_SIMPLE_HTTP_Buffer;
+
 void c_simple_http_cleanup_attr_string_part(C_SIMPLE_HTTP_String_Part **);
 
 /// Assumes "data" is a C_SIMPLE_HTTP_String_Part, "data" was malloced, and
@@ -79,10 +92,6 @@ char *c_simple_http_helper_to_lowercase(const char *buf, size_t size);
 /// Converts two hexadecimal digits into its corresponding value.
 char c_simple_http_helper_hex_to_value(const char upper, const char lower);
 
-/// Unescapes percent-encoded parts in the given uri string. If this returns
-/// non-NULL, it must be free'd.
-char *c_simple_http_helper_unescape_uri(const char *uri);
-
 /// Returns zero if successful. "dirpath" will point to a directory on success.
 /// Returns 1 if the directory already exists.
 /// Other return values are errors.
@@ -93,6 +102,19 @@ void c_simple_http_cleanup_DIR(DIR **fd);
 /// Must be free'd if non-NULL.
 char *c_simple_http_FILE_to_c_str(const char *filename, uint64_t *size_out);
 
+/// Appends "size" bytes from "data" to the buffer, growing it if necessary.
+/// Returns zero on success.
+int c_simple_http_buffer_append(C_SIMPLE_HTTP_Buffer *buffer,
+                                const void *data,
+                                size_t size);
+
+/// Frees the memory held by the buffer and resets it to empty.
+void c_simple_http_buffer_cleanup(C_SIMPLE_HTTP_Buffer *buffer);
+
+/// Returns the number of milliseconds elapsed from "from" to "to".
+int64_t c_simple_http_helper_timespec_diff_millis(const struct timespec *from,
+                                                  const struct timespec *to);
+
 /// Trims by placing NULL bytes in place of whitespace at the end of c_str.
 /// Returns number of whitespace trimmed.
 size_t c_simple_http_trim_end_whitespace(char *c_str);
@@ -216,7 +216,9 @@ int c_simple_http_cache_path(
     const char *cache_dir,
     C_SIMPLE_HTTP_HTTPTemplates *templates,
     size_t cache_entry_lifespan,
-    char **buf_out) {
+    int_fast8_t read_only,
+    char **buf_out,
+    size_t *size_out) {
   if (!path) {
     fprintf(stderr, "ERROR cache_path function: path is NULL!\n");
     return -9;
@@ -229,16 +231,29 @@ int c_simple_http_cache_path(
   } else if (!templates) {
     fprintf(stderr, "ERROR cache_path function: templates is NULL!\n");
     return -12;
-  } else if (!buf_out) {
-    fprintf(stderr, "ERROR cache_path function: buf_out is NULL!\n");
+  } else if (!buf_out && !size_out) {
+    fprintf(stderr,
+            "ERROR cache_path function: buf_out and size_out are NULL!\n");
     return -13;
   }
 
-  int ret = c_simple_http_helper_mkdir_tree(cache_dir);
-  if (ret != 0 && ret != 1) {
-    fprintf(
-      stderr, "ERROR failed to ensure cache_dir \"%s\" exists!\n", cache_dir);
-    return -15;
+  int ret;
+  if (read_only) {
+    // Generating would fail, and only a config reload could change that.
+    if (simple_archiver_hash_map_get(templates->hash_map,
+                                     path,
+                                     strlen(path) + 1)
+        == NULL) {
+      return -4;
+    }
+    // A missing cache_dir is created when the entry is written.
+  } else {
+    ret = c_simple_http_helper_mkdir_tree(cache_dir);
+    if (ret != 0 && ret != 1) {
+      fprintf(
+        stderr, "ERROR failed to ensure cache_dir \"%s\" exists!\n", cache_dir);
+      return -15;
+    }
   }
 
   // Get the cache filename from the path.
@@ -274,7 +289,9 @@ int c_simple_http_cache_path(
   memset(&cache_file_stat, 0, sizeof(struct stat));
   ret = stat(cache_filename_full, &cache_file_stat);
   if (ret == -1) {
-    if (errno == ENOENT) {
+    if (read_only) {
+      return 2;
+    } else if (errno == ENOENT) {
       fprintf(stderr, "NOTICE cache file doesn't exist, will create...\n");
     } else {
       fprintf(
@@ -412,6 +429,9 @@ CACHE_FILE_WRITE_CHECK:
          > (ssize_t)cache_entry_lifespan))
   {
     // Cache file is out of date.
+    if (read_only) {
+      return 2;
+    }
 
     if (cache_file_stat.st_mtim.tv_sec < config_file_stat.st_mtim.tv_sec
         || (cache_file_stat.st_mtim.tv_sec == config_file_stat.st_mtim.tv_sec
@@ -476,8 +496,13 @@ CACHE_FILE_WRITE_CHECK:
       return -8;
     }
 
-    *buf_out = generated_html;
-    generated_html = NULL;
+    if (size_out) {
+      *size_out = generated_html_size;
+    }
+    if (buf_out) {
+      *buf_out = generated_html;
+      generated_html = NULL;
+    }
     return 1;
   }
 
@@ -575,6 +600,13 @@ CACHE_FILE_WRITE_CHECK:
   }
 
   const size_t html_size = (size_t)html_end_idx - (size_t)html_start_idx + 1;
+  if (size_out) {
+    *size_out = html_size - 1;
+  }
+  if (!buf_out) {
+    // Only the size was wanted, which is known without reading the html.
+    return 0;
+  }
   *buf_out = malloc(html_size);
 
   if (fread(*buf_out, 1, html_size - 1, cache_fd) != html_size - 1) {
@@ -31,6 +31,12 @@ char *c_simple_http_cache_filename_to_path(const char *cache_filename);
 /// required to actually get the cache file to check against. "buf_out" will be
 /// populated if non-NULL, and will either be fetched from the cache or from the
 /// config (using http_template). Note that "buf_out" will point to a c-string.
+/// "size_out" is set to the size of the html if non-NULL. "buf_out" may be
+/// NULL if "size_out" is not, and then an up to date cache entry's html is not
+/// read. If "read_only" is non-zero, nothing is written and "templates" is
+/// not reloaded, so that it may be called with "templates" only read locked.
+/// Then 2 is returned instead if the cache entry is out of date, and a path
+/// that is not in "templates" is an error.
 /// Returns a negative value on error.
 int c_simple_http_cache_path(
   const char *path,
@@ -38,7 +44,9 @@ int c_simple_http_cache_path(
   const char *cache_dir,
   C_SIMPLE_HTTP_HTTPTemplates *templates,
   size_t cache_entry_lifespan,
-  char **buf_out);
+  int_fast8_t read_only,
+  char **buf_out,
+  size_t *size_out);
 
 #endif
 
@@ -21,37 +21,57 @@
 #include <string.h>
 #include <stdio.h>
 
+// Linux/Unix includes.
+#include <strings.h>
+
 // Third party includes.
 #include <SimpleArchiver/src/helpers.h>
-#include <SimpleArchiver/src/data_structures/linked_list.h>
+#include <SimpleArchiver/src/data_structures/hash_map.h>
 
 // Local includes
+#include "header_scan.h"
 #include "http_template.h"
 #include "helpers.h"
 #include "html_cache.h"
 
-#define REQUEST_TYPE_BUFFER_SIZE 16
-#define REQUEST_PATH_BUFFER_SIZE 256
-#define REQUEST_PROTO_BUFFER_SIZE 16
-
 const char *c_simple_http_response_code_error_to_response(
     enum C_SIMPLE_HTTP_ResponseCode response_code) {
   switch (response_code) {
     case C_SIMPLE_HTTP_Response_400_Bad_Request:
-      return "HTTP/1.1 400 Bad Request\nAllow: GET\n"
+      return "HTTP/1.1 400 Bad Request\nAllow: GET, HEAD\n"
              "Connection: close\n"
              "Content-Type: text/html\n"
              "Content-Length: 25\n\n"
              "<h1>400 Bad Request</h1>\n";
     case C_SIMPLE_HTTP_Response_404_Not_Found:
-      return "HTTP/1.1 404 Not Found\nAllow: GET\n"
+      return "HTTP/1.1 404 Not Found\nAllow: GET, HEAD\n"
              "Connection: close\n"
              "Content-Type: text/html\n"
              "Content-Length: 23\n\n"
              "<h1>404 Not Found</h1>\n";
+    case C_SIMPLE_HTTP_Response_431_Request_Header_Fields_Too_Large:
+      return "HTTP/1.1 431 Request Header Fields Too Large\nAllow: GET, HEAD\n"
+             "Connection: close\n"
+             "Content-Type: text/html\n"
+             "Content-Length: 45\n\n"
+             "<h1>431 Request Header Fields Too Large</h1>\n";
+    case C_SIMPLE_HTTP_Response_429_Too_Many_Requests:
+      return "HTTP/1.1 429 Too Many Requests\nAllow: GET, HEAD\n"
+             "Retry-After: 1\n"
+             "Connection: close\n"
+             "Content-Type: text/html\n"
+             "Content-Length: 31\n\n"
+             "<h1>429 Too Many Requests</h1>\n";
+    case C_SIMPLE_HTTP_Response_503_Service_Unavailable:
+      return "HTTP/1.1 503 Service Unavailable\nAllow: GET, HEAD\n"
+             "Retry-After: 1\n"
+             "Connection: close\n"
+             "Content-Type: text/html\n"
+             "Content-Length: 33\n\n"
+             "<h1>503 Service Unavailable</h1>\n";
     case C_SIMPLE_HTTP_Response_500_Internal_Server_Error:
     default:
-      return "HTTP/1.1 500 Internal Server Error\nAllow: GET\n"
+      return "HTTP/1.1 500 Internal Server Error\nAllow: GET, HEAD\n"
              "Connection: close\n"
              "Content-Type: text/html\n"
              "Content-Length: 35\n\n"
@@ -59,110 +79,139 @@ const char *c_simple_http_response_code_error_to_response(
   }
 }
 
+int c_simple_http_internal_is_blank(char c) {
+  return c == ' ' || c == '\t';
+}
+
+int c_simple_http_parse_request(char *request,
+                                size_t size,
+                                C_SIMPLE_HTTP_ParsedRequest *out) {
+  out->method.size = 0;
+  out->path.size = 0;
+  out->version.size = 0;
+  out->header_count = 0;
+  memset(out->known_headers, 0, sizeof(out->known_headers));
+
+  // Request line: "<method> <target> <version>".
+  C_SIMPLE_HTTP_Slice *parts[3] = {&out->method, &out->path, &out->version};
+  size_t idx = 0;
+  for (uint_fast8_t part = 0; part < 3; ++part) {
+    for (; idx < size && c_simple_http_internal_is_blank(request[idx]); ++idx) {
+    }
+    parts[part]->ptr = request + idx;
+    for (; idx < size
+        && !c_simple_http_internal_is_blank(request[idx])
+        && request[idx] != '\r'
+        && request[idx] != '\n';
+        ++idx) {
+    }
+    parts[part]->size = (size_t)(request + idx - parts[part]->ptr);
+    if (parts[part]->size == 0) {
+      return 1;
+    }
+  }
+
+  // The target is followed by at least the blank before the version, which
+  // leaves room for the NUL.
+  char *path = request + (out->path.ptr - request);
+  if (c_simple_http_normalize_path(path, &out->path.size, 3) != 0) {
+    return 1;
+  }
+
+  const char *line_end = request + idx
+    + c_simple_http_header_scan_find(request + idx, size - idx, '\n', '\n');
+  if (line_end == request + size) {
+    return 0;
+  }
+
+  // Header lines, up to the empty line. Each line is scanned once for its
+  // ':' and then its '\n'.
+  for (idx = (size_t)(line_end - request) + 1; idx < size;) {
+    const char *line = request + idx;
+    const size_t remaining = size - idx;
+    size_t line_size =
+      c_simple_http_header_scan_find(line, remaining, ':', '\n');
+    const char *colon = NULL;
+    if (line_size < remaining && line[line_size] == ':') {
+      colon = line + line_size;
+      line_size += 1 + c_simple_http_header_scan_find(colon + 1,
+                                                      remaining - line_size - 1,
+                                                      '\n',
+                                                      '\n');
+    }
+    idx += line_size + 1;
+    if (line_size != 0 && line[line_size - 1] == '\r') {
+      --line_size;
+    }
+    if (line_size == 0) {
+      break;
+    }
+
+    if (!colon || colon == line || c_simple_http_internal_is_blank(line[0])) {
+      continue;
+    } else if (out->header_count == C_SIMPLE_HTTP_MAX_HEADERS) {
+      return 2;
+    }
+    C_SIMPLE_HTTP_Header *header = out->headers + out->header_count++;
+    header->name.ptr = line;
+    header->name.size = (size_t)(colon - line);
+
+    const char *value = colon + 1;
+    const char *value_end = line + line_size;
+    for (; value < value_end && c_simple_http_internal_is_blank(*value);
+        ++value) {
+    }
+    for (; value_end > value
+        && c_simple_http_internal_is_blank(value_end[-1]);
+        --value_end) {
+    }
+    header->value.ptr = value;
+    header->value.size = (size_t)(value_end - value);
+
+    const enum C_SIMPLE_HTTP_KnownHeader known =
+      c_simple_http_known_header(header->name.ptr, header->name.size);
+    if (known != C_SIMPLE_HTTP_KnownHeader_Unknown
+        && out->known_headers[known] == 0) {
+      out->known_headers[known] = (uint8_t)out->header_count;
+    }
+  }
+
+  return 0;
+}
+
 char *c_simple_http_request_response(
-    const char *request,
-    uint32_t size,
+    const C_SIMPLE_HTTP_ParsedRequest *request,
     C_SIMPLE_HTTP_HTTPTemplates *templates,
     size_t *out_size,
     enum C_SIMPLE_HTTP_ResponseCode *out_response_code,
     const Args *args,
-    char **request_path_out) {
+    int_fast8_t *out_needs_write_lock) {
   if (out_size) {
     *out_size = 0;
   }
-  // parse first line.
-  uint32_t idx = 0;
-  char request_type[REQUEST_TYPE_BUFFER_SIZE] = {0};
-  uint32_t request_type_idx = 0;
-  for (; idx < size
-      && request[idx] != ' '
-      && request[idx] != '\n'
-      && request[idx] != '\r'
-      && request[idx] != '\t'
-      && request_type_idx < REQUEST_TYPE_BUFFER_SIZE - 1;
-        ++idx) {
-    request_type[request_type_idx++] = request[idx];
-  }
-  if (request_type_idx == 0) {
-    if (out_response_code) {
-      *out_response_code = C_SIMPLE_HTTP_Response_400_Bad_Request;
-    }
-    return NULL;
+  if (out_needs_write_lock) {
+    *out_needs_write_lock = 0;
   }
 #ifndef NDEBUG
-  fprintf(stderr, "Parsing request: got type \"%s\"\n", request_type);
-#endif
-  // skip whitespace until next part.
-  for (; idx < size
-      && (request[idx] == ' ' ||
-          request[idx] == '\n' ||
-          request[idx] == '\r' ||
-          request[idx] == '\t');
-      ++idx) {}
-  // parse request path.
-  char request_path[REQUEST_PATH_BUFFER_SIZE] = {0};
-  uint32_t request_path_idx = 0;
-  for (; idx < size
-      && request[idx] != ' '
-      && request[idx] != '\n'
-      && request[idx] != '\r'
-      && request[idx] != '\t'
-      && request_path_idx < REQUEST_PATH_BUFFER_SIZE - 1;
-        ++idx) {
-    request_path[request_path_idx++] = request[idx];
-  }
-  if (request_path_idx == 0) {
-    if (out_response_code) {
-      *out_response_code = C_SIMPLE_HTTP_Response_400_Bad_Request;
-    }
-    return NULL;
-  }
-#ifndef NDEBUG
-  fprintf(stderr, "Parsing request: got path \"%s\"\n", request_path);
-#endif
-  __attribute__((cleanup(simple_archiver_helper_cleanup_c_string)))
-  char *request_path_unescaped =
-    c_simple_http_helper_unescape_uri(request_path);
-#ifndef NDEBUG
-  fprintf(
-    stderr, "Parsing request: unescaped path \"%s\"\n", request_path_unescaped);
-#endif
-  // skip whitespace until next part.
-  for (; idx < size
-      && (request[idx] == ' ' ||
-          request[idx] == '\n' ||
-          request[idx] == '\r' ||
-          request[idx] == '\t');
-      ++idx) {}
-  // parse request http protocol.
-  char request_proto[REQUEST_PROTO_BUFFER_SIZE] = {0};
-  uint32_t request_proto_idx = 0;
-  for (; idx < size
-      && request[idx] != ' '
-      && request[idx] != '\n'
-      && request[idx] != '\r'
-      && request[idx] != '\t'
-      && request_proto_idx < REQUEST_PROTO_BUFFER_SIZE - 1;
-        ++idx) {
-    request_proto[request_proto_idx++] = request[idx];
-  }
-  if (request_proto_idx == 0) {
-    if (out_response_code) {
-      *out_response_code = C_SIMPLE_HTTP_Response_400_Bad_Request;
-    }
-    return NULL;
-  }
-#ifndef NDEBUG
-  fprintf(stderr, "Parsing request: got http protocol \"%s\"\n", request_proto);
+  fprintf(stderr,
+          "Parsing request: got type \"%.*s\", path \"%s\", "
+          "http protocol \"%.*s\"\n",
+          (int)request->method.size, request->method.ptr,
+          request->path.ptr,
+          (int)request->version.size, request->version.ptr);
 #endif
 
-  if (strcmp(request_type, "GET") != 0) {
-    fprintf(stderr, "ERROR Only GET requests are allowed!\n");
+  const int_fast8_t is_head = c_simple_http_request_is_head(request) ? 1 : 0;
+  if (!is_head
+      && (request->method.size != 3
+        || memcmp(request->method.ptr, "GET", 3) != 0)) {
+    fprintf(stderr, "ERROR Only GET and HEAD requests are allowed!\n");
     if (out_response_code) {
       *out_response_code = C_SIMPLE_HTTP_Response_400_Bad_Request;
     }
     return NULL;
-  } else if (strcmp(request_proto, "HTTP/1.1") != 0) {
+  } else if (request->version.size != 8
+      || memcmp(request->version.ptr, "HTTP/1.1", 8) != 0) {
     fprintf(stderr, "ERROR Only HTTP/1.1 protocol requests are allowed!\n");
     if (out_response_code) {
       *out_response_code = C_SIMPLE_HTTP_Response_400_Bad_Request;
@@ -171,64 +220,49 @@ char *c_simple_http_request_response(
   }
 
   size_t generated_size = 0;
-  __attribute__((cleanup(simple_archiver_helper_cleanup_c_string)))
-  char *stripped_path = c_simple_http_strip_path(
-    request_path_unescaped, strlen(request_path_unescaped));
-
   char *generated_buf = NULL;
-
-  if (request_path_out) {
-    *request_path_out =
-      strdup(stripped_path ? stripped_path : request_path_unescaped);
-  }
+  int_fast8_t generated = 0;
 
   if (args->cache_dir) {
+    // HEAD only needs the size, which is known from an up to date cache entry
+    // without reading it.
     int ret = c_simple_http_cache_path(
-      stripped_path ? stripped_path : request_path_unescaped,
+      request->path.ptr,
       args->config_file,
       args->cache_dir,
       templates,
       args->cache_lifespan_seconds,
-      &generated_buf);
-    if (ret < 0) {
-      fprintf(stderr, "ERROR Failed to generate template with cache!\n");
-      if (out_response_code) {
-        if (
-            simple_archiver_hash_map_get(
-              templates->hash_map,
-              stripped_path ? stripped_path : request_path_unescaped,
-              stripped_path
-                ? strlen(stripped_path) + 1
-                : strlen(request_path_unescaped) + 1)
-            == NULL) {
-          *out_response_code = C_SIMPLE_HTTP_Response_404_Not_Found;
-        } else {
-          *out_response_code = C_SIMPLE_HTTP_Response_500_Internal_Server_Error;
-        }
-      }
+      out_needs_write_lock ? 1 : 0,
+      is_head ? NULL : &generated_buf,
+      &generated_size);
+    if (ret == 2) {
+      // The out of date entry is updated once the caller holds a write lock.
+      *out_needs_write_lock = 1;
       return NULL;
+    } else if (ret < 0) {
+      fprintf(stderr, "ERROR Failed to generate template with cache!\n");
+      generated_buf = NULL;
+    } else {
+      generated = 1;
     }
-    generated_size = strlen(generated_buf);
   } else {
     generated_buf = c_simple_http_path_to_generated(
-      stripped_path ? stripped_path : request_path_unescaped,
+      request->path.ptr,
       templates,
       &generated_size,
       NULL);
+    generated = generated_buf ? 1 : 0;
   }
 
-  if (!generated_buf || generated_size == 0) {
+  if (!generated || generated_size == 0) {
     fprintf(stderr,
             "WARNING Unable to generate response html for path \"%s\"!\n",
-      request_path);
+            request->path.ptr);
+    free(generated_buf);
     if (out_response_code) {
-      if (
-          simple_archiver_hash_map_get(
-            templates->hash_map,
-            stripped_path ? stripped_path : request_path_unescaped,
-            stripped_path
-              ? strlen(stripped_path) + 1
-              : strlen(request_path_unescaped) + 1)
+      if (simple_archiver_hash_map_get(templates->hash_map,
+                                       request->path.ptr,
+                                       request->path.size + 1)
           == NULL) {
         *out_response_code = C_SIMPLE_HTTP_Response_404_Not_Found;
       } else {
@@ -236,6 +270,9 @@ char *c_simple_http_request_response(
       }
     }
     return NULL;
+  } else if (is_head) {
+    free(generated_buf);
+    generated_buf = NULL;
   }
 
   if (out_size) {
@@ -247,172 +284,211 @@ char *c_simple_http_request_response(
   return generated_buf;
 }
 
-char *c_simple_http_strip_path(const char *path, size_t path_size) {
-  if (path_size == 1 && path[0] == '/') {
-    // Edge case: root path.
-    char *buf = malloc(2);
-    buf[0] = '/';
-    buf[1] = 0;
-    return buf;
-  }
+int c_simple_http_request_is_head(const C_SIMPLE_HTTP_ParsedRequest *request) {
+  return request->method.size == 4
+    && memcmp(request->method.ptr, "HEAD", 4) == 0;
+}
 
-  size_t idx = 0;
-  for (; idx < path_size && path[idx] != 0; ++idx) {
-    if (path[idx] == '?' || path[idx] == '#') {
+int c_simple_http_normalize_path(char *path, size_t *size, uint32_t flags) {
+  // Bytes are only ever moved towards the start, so the output never catches
+  // up with the unread input.
+  size_t out_idx = 0;
+  size_t segment_idx = 0;
+  for (size_t idx = 0; idx < *size; ++idx) {
+    char c = path[idx];
+    if (c == '?' || c == '#' || c == 0) {
       break;
-    }
-  }
-
-  char *stripped_path = malloc(idx + 1);
-  memcpy(stripped_path, path, idx);
-  stripped_path[idx] = 0;
-
-  // Strip multiple '/' into one.
-  __attribute((cleanup(simple_archiver_list_free)))
-  SDArchiverLinkedList *parts = simple_archiver_list_init();
-
-  idx = 0;
-  size_t prev_idx = 0;
-  size_t size;
-  char *buf;
-  uint_fast8_t slash_visited = 0;
-
-  for (; stripped_path[idx] != 0; ++idx) {
-    if (stripped_path[idx] == '/') {
-      if (slash_visited) {
-        // Intentionally left blank.
-      } else {
-        slash_visited = 1;
-
-        if (idx > prev_idx) {
-          size = idx - prev_idx + 1;
-          buf = malloc(size);
-          memcpy(buf, stripped_path + prev_idx, size - 1);
-          buf[size - 1] = 0;
-
-          c_simple_http_add_string_part(parts, buf, 0);
-          free(buf);
-        }
+    } else if (c == '%' && (flags & 1) != 0) {
+      // A truncated escape is as invalid as one that is not hexadecimal.
+      if (idx + 2 >= *size) {
+        return 1;
       }
-    } else {
-      if (slash_visited) {
-        buf = malloc(2);
-        buf[0] = '/';
-        buf[1] = 0;
-
-        c_simple_http_add_string_part(parts, buf, 0);
-        free(buf);
-
-        prev_idx = idx;
+      c = c_simple_http_helper_hex_to_value(path[idx + 1], path[idx + 2]);
+      if (c == 0) {
+        return 1;
       }
+      idx += 2;
+    }
 
-      slash_visited = 0;
+    if (c == '/') {
+      if (out_idx != 0 && path[out_idx - 1] == '/') {
+        continue;
+      } else if ((flags & 2) != 0
+          && out_idx - segment_idx == 2
+          && path[segment_idx] == '.'
+          && path[segment_idx + 1] == '.') {
+        return 2;
+      }
+      segment_idx = out_idx + 1;
     }
+    path[out_idx++] = c;
   }
 
-  if (!slash_visited && idx > prev_idx) {
-    size = idx - prev_idx + 1;
-    buf = malloc(size);
-    memcpy(buf, stripped_path + prev_idx, size - 1);
-    buf[size - 1] = 0;
-
-    c_simple_http_add_string_part(parts, buf, 0);
-    free(buf);
-  } else if (slash_visited && prev_idx == 0) {
-    buf = malloc(2);
-    buf[0] = '/';
-    buf[1] = 0;
-
-    c_simple_http_add_string_part(parts, buf, 0);
-    free(buf);
+  if ((flags & 2) != 0
+      && out_idx - segment_idx == 2
+      && path[segment_idx] == '.'
+      && path[segment_idx + 1] == '.') {
+    return 2;
   }
+  while (out_idx > 1 && path[out_idx - 1] == '/') {
+    --out_idx;
+  }
+  path[out_idx] = 0;
+  *size = out_idx;
+  return 0;
+}
 
-  free(stripped_path);
-
-  stripped_path = c_simple_http_combine_string_parts(parts);
+char *c_simple_http_strip_path(const char *path, size_t path_size) {
+  char *stripped_path = malloc(path_size + 1);
+  memcpy(stripped_path, path, path_size);
+  c_simple_http_normalize_path(stripped_path, &path_size, 0);
+  return stripped_path;
+}
 
-  // Strip trailing '/'.
-  idx = strlen(stripped_path);
-  while (idx-- > 1) {
-    if (stripped_path[idx] == '/' || stripped_path[idx] == 0) {
-      stripped_path[idx] = 0;
-    } else {
+int c_simple_http_path_has_dot_dot(const char *path) {
+  for (const char *segment = path; *segment != 0;) {
+    const char *segment_end = strchr(segment, '/');
+    if (!segment_end) {
+      segment_end = segment + strlen(segment);
+    }
+    if (segment_end - segment == 2 && segment[0] == '.' && segment[1] == '.') {
+      return 1;
+    } else if (*segment_end == 0) {
       break;
     }
+    segment = segment_end + 1;
   }
+  return 0;
+}
 
-  return stripped_path;
+enum C_SIMPLE_HTTP_KnownHeader c_simple_http_known_header(const char *name,
+                                                          size_t name_size) {
+  // No two known headers have the same length, so a match is confirmed with
+  // one compare.
+  const char *known_name;
+  enum C_SIMPLE_HTTP_KnownHeader known;
+  switch (name_size) {
+    case 4:
+      known_name = "host";
+      known = C_SIMPLE_HTTP_KnownHeader_Host;
+      break;
+    case 5:
+      known_name = "range";
+      known = C_SIMPLE_HTTP_KnownHeader_Range;
+      break;
+    case 10:
+      known_name = "connection";
+      known = C_SIMPLE_HTTP_KnownHeader_Connection;
+      break;
+    case 13:
+      known_name = "if-none-match";
+      known = C_SIMPLE_HTTP_KnownHeader_IfNoneMatch;
+      break;
+    case 15:
+      known_name = "accept-encoding";
+      known = C_SIMPLE_HTTP_KnownHeader_AcceptEncoding;
+      break;
+    case 17:
+      known_name = "if-modified-since";
+      known = C_SIMPLE_HTTP_KnownHeader_IfModifiedSince;
+      break;
+    default:
+      return C_SIMPLE_HTTP_KnownHeader_Unknown;
+  }
+  if (strncasecmp(name, known_name, name_size) != 0) {
+    return C_SIMPLE_HTTP_KnownHeader_Unknown;
+  }
+  return known;
 }
 
-SDArchiverHashMap *c_simple_http_request_to_headers_map(
-    const char *request, size_t request_size) {
-  SDArchiverHashMap *hash_map = simple_archiver_hash_map_init();
+const C_SIMPLE_HTTP_Header *c_simple_http_request_known_header(
+    const C_SIMPLE_HTTP_ParsedRequest *request,
+    enum C_SIMPLE_HTTP_KnownHeader known) {
+  if (known >= C_SIMPLE_HTTP_KnownHeader_Count
+      || request->known_headers[known] == 0) {
+    return NULL;
+  }
+  return request->headers + request->known_headers[known] - 1;
+}
 
-  // xxxx xx00 - Beginning of line.
-  // xxxx xx01 - Reached end of header key.
-  // xxxx xx10 - Non-header line.
-  uint32_t state = 0;
-  size_t idx = 0;
-  size_t header_key_idx = 0;
-  __attribute__((cleanup(simple_archiver_helper_cleanup_c_string)))
-  char *key_buf = NULL;
-  size_t key_buf_size = 0;
-  __attribute__((cleanup(simple_archiver_helper_cleanup_c_string)))
-  char *value_buf = NULL;
-  for (; idx < request_size; ++idx) {
-    if ((state & 3) == 0) {
-      if ((request[idx] >= 'a' && request[idx] <= 'z')
-          || (request[idx] >= 'A' && request[idx] <= 'Z')
-          || request[idx] == '-') {
-        continue;
-      } else if (request[idx] == ':') {
-        key_buf_size = idx - header_key_idx + 1;
-        key_buf = malloc(key_buf_size);
-        memcpy(key_buf, request + header_key_idx, key_buf_size - 1);
-        key_buf[key_buf_size - 1] = 0;
-        c_simple_http_helper_to_lowercase_in_place(key_buf, key_buf_size);
-        state &= 0xFFFFFFFC;
-        state |= 1;
-      } else {
-        state &= 0xFFFFFFFC;
-        state |= 2;
-      }
-    } else if ((state & 3) == 1) {
-      if (request[idx] == '\n') {
-        size_t value_buf_size = idx - header_key_idx + 1;
-        value_buf = malloc(value_buf_size);
-        memcpy(value_buf, request + header_key_idx, value_buf_size - 1);
-        value_buf[value_buf_size - 1] = 0;
-        simple_archiver_hash_map_insert(
-          hash_map, value_buf, key_buf, key_buf_size, NULL, NULL);
-        key_buf = NULL;
-        value_buf = NULL;
-        key_buf_size = 0;
-        header_key_idx = idx + 1;
-        state &= 0xFFFFFFFC;
-      }
-    } else if ((state & 3) == 2) {
-      // Do nothing, just wait until '\n' is parsed.
+const C_SIMPLE_HTTP_Header *c_simple_http_request_get_header(
+    const C_SIMPLE_HTTP_ParsedRequest *request,
+    const char *name,
+    size_t name_size) {
+  const enum C_SIMPLE_HTTP_KnownHeader known =
+    c_simple_http_known_header(name, name_size);
+  if (known != C_SIMPLE_HTTP_KnownHeader_Unknown) {
+    return c_simple_http_request_known_header(request, known);
+  }
+  for (uint32_t idx = 0; idx < request->header_count; ++idx) {
+    const C_SIMPLE_HTTP_Header *header = request->headers + idx;
+    if (header->name.size == name_size
+        && strncasecmp(header->name.ptr, name, name_size) == 0) {
+      return header;
     }
+  }
+  return NULL;
+}
 
-    if (request[idx] == '\n') {
-      header_key_idx = idx + 1;
-      state &= 0xFFFFFFFC;
+size_t c_simple_http_request_headers_end(const char *request,
+                                         size_t size,
+                                         size_t *scan_idx) {
+  const size_t start = scan_idx ? *scan_idx : 0;
+  const char *line_end = memchr(request + start, '\n', size - start);
+  while (line_end) {
+    const size_t idx = (size_t)(line_end - request);
+    if (idx + 1 < size && request[idx + 1] == '\n') {
+      return idx + 2;
+    } else if (idx + 2 < size
+        && request[idx + 1] == '\r'
+        && request[idx + 2] == '\n') {
+      return idx + 3;
     }
+    line_end = memchr(line_end + 1, '\n', size - idx - 1);
   }
 
-  if (key_buf && key_buf_size != 0 && !value_buf && idx > header_key_idx) {
-    size_t value_buf_size = idx - header_key_idx + 1;
-    value_buf = malloc(value_buf_size);
-    memcpy(value_buf, request + header_key_idx, value_buf_size - 1);
-    value_buf[value_buf_size - 1] = 0;
-    simple_archiver_hash_map_insert(
-      hash_map, value_buf, key_buf, key_buf_size, NULL, NULL);
-    key_buf = NULL;
-    value_buf = NULL;
+  if (scan_idx) {
+    // The last two bytes may be the start of the terminator.
+    *scan_idx = size > start + 2 ? size - 2 : start;
+  }
+  return 0;
+}
+
+int c_simple_http_request_connection_close(
+    const C_SIMPLE_HTTP_ParsedRequest *request) {
+  // HTTP/1.0 connections are not persistent by default.
+  int close = request->version.size == 8
+    && memcmp(request->version.ptr, "HTTP/1.0", 8) == 0;
+  const C_SIMPLE_HTTP_Header *header = c_simple_http_request_known_header(
+    request, C_SIMPLE_HTTP_KnownHeader_Connection);
+  if (!header) {
+    return close;
+  }
+
+  // The value is a comma separated list of options.
+  const char *value = header->value.ptr;
+  const char *value_end = value + header->value.size;
+  while (value < value_end) {
+    while (value < value_end
+        && (*value == ' ' || *value == '\t' || *value == ',')) {
+      ++value;
+    }
+    size_t length = 0;
+    while (value + length < value_end
+        && value[length] != ','
+        && value[length] != ' '
+        && value[length] != '\t') {
+      ++length;
+    }
+    if (length == 5 && strncasecmp(value, "close", 5) == 0) {
+      return 1;
+    } else if (length == 10 && strncasecmp(value, "keep-alive", 10) == 0) {
+      close = 0;
+    }
+    value += length;
   }
 
-  return hash_map;
+  return close;
 }
 
 // vim: et ts=2 sts=2 sw=2
@@ -21,20 +21,60 @@
 #include <stddef.h>
 #include <stdint.h>
 
-// Third party includes.
-#include <SimpleArchiver/src/data_structures/hash_map.h>
-
 // Local includes.
 #include "arg_parse.h"
 #include "config.h"
+#include "constants.h"
 
 typedef C_SIMPLE_HTTP_ParsedConfig C_SIMPLE_HTTP_HTTPTemplates;
 
+/// "size" bytes at "ptr", which are not NUL terminated.
+typedef struct C_SIMPLE_HTTP_Slice {
+  const char *ptr;
+  size_t size;
+} C_SIMPLE_HTTP_Slice;
+
+typedef struct C_SIMPLE_HTTP_Header {
+  C_SIMPLE_HTTP_Slice name;
+  /// Without leading or trailing whitespace.
+  C_SIMPLE_HTTP_Slice value;
+} C_SIMPLE_HTTP_Header;
+
+/// Headers that get a slot in C_SIMPLE_HTTP_ParsedRequest when parsed.
+/// Each must have a different length (see c_simple_http_known_header()).
+enum C_SIMPLE_HTTP_KnownHeader {
+  C_SIMPLE_HTTP_KnownHeader_Host,
+  C_SIMPLE_HTTP_KnownHeader_Connection,
+  C_SIMPLE_HTTP_KnownHeader_AcceptEncoding,
+  C_SIMPLE_HTTP_KnownHeader_IfNoneMatch,
+  C_SIMPLE_HTTP_KnownHeader_IfModifiedSince,
+  C_SIMPLE_HTTP_KnownHeader_Range,
+  C_SIMPLE_HTTP_KnownHeader_Count,
+  C_SIMPLE_HTTP_KnownHeader_Unknown = C_SIMPLE_HTTP_KnownHeader_Count,
+};
+
+/// Views into the bytes of a received request, which must outlive it.
+typedef struct C_SIMPLE_HTTP_ParsedRequest {
+  C_SIMPLE_HTTP_Slice method;
+  /// The request target normalised in place by c_simple_http_normalize_path,
+  /// followed by a NUL.
+  C_SIMPLE_HTTP_Slice path;
+  C_SIMPLE_HTTP_Slice version;
+  C_SIMPLE_HTTP_Header headers[C_SIMPLE_HTTP_MAX_HEADERS];
+  uint32_t header_count;
+  /// One plus the index in "headers" of the first of each known header, or
+  /// zero if the request does not have it.
+  uint8_t known_headers[C_SIMPLE_HTTP_KnownHeader_Count];
+} C_SIMPLE_HTTP_ParsedRequest;
+
 enum C_SIMPLE_HTTP_ResponseCode {
   C_SIMPLE_HTTP_Response_200_OK,
   C_SIMPLE_HTTP_Response_400_Bad_Request,
   C_SIMPLE_HTTP_Response_404_Not_Found,
   C_SIMPLE_HTTP_Response_500_Internal_Server_Error,
+  C_SIMPLE_HTTP_Response_431_Request_Header_Fields_Too_Large,
+  C_SIMPLE_HTTP_Response_429_Too_Many_Requests,
+  C_SIMPLE_HTTP_Response_503_Service_Unavailable,
 };
 
 // If the response code is an error, returns a full response string that doesn't
@@ -42,30 +82,90 @@ enum C_SIMPLE_HTTP_ResponseCode {
 const char *c_simple_http_response_code_error_to_response(
   enum C_SIMPLE_HTTP_ResponseCode response_code);
 
+/// Parses the request line and headers of "request" in a single pass without
+/// copying or allocating, "out" pointing into "request" afterwards. "size"
+/// should be up to the end of its headers (see
+/// c_simple_http_request_headers_end). The request target is normalised in
+/// place into "out->path". Header lines without a ":" are skipped.
+/// Returns zero on success, 1 if the request line or its path is invalid, or
+/// 2 if there are more than C_SIMPLE_HTTP_MAX_HEADERS headers.
+int c_simple_http_parse_request(char *request,
+                                size_t size,
+                                C_SIMPLE_HTTP_ParsedRequest *out);
+
 /// Returned buffer must be "free"d after use.
 /// If the request is not valid, or 404, then the buffer will be NULL.
+/// For a HEAD request, NULL is returned on success too, with "*out_size" set
+/// to the size the body would have.
+/// If "out_needs_write_lock" is non-NULL, "templates" is only read (see
+/// c_simple_http_cache_path's "read_only"). If the cache entry is then out of
+/// date, NULL is returned with "*out_needs_write_lock" set to 1, and this
+/// should be called again with "templates" write locked and a NULL
+/// "out_needs_write_lock".
 char *c_simple_http_request_response(
-  const char *request,
-  uint32_t size,
+  const C_SIMPLE_HTTP_ParsedRequest *request,
   C_SIMPLE_HTTP_HTTPTemplates *templates,
   size_t *out_size,
   enum C_SIMPLE_HTTP_ResponseCode *out_response_code,
   const Args *args,
-  char **request_path_out
+  int_fast8_t *out_needs_write_lock
 );
 
+/// Returns non-zero if "request" is a HEAD request.
+int c_simple_http_request_is_head(const C_SIMPLE_HTTP_ParsedRequest *request);
+
+/// Normalises the "*size" bytes of "path" in a single pass in place, updating
+/// "*size" and writing a NUL after them, so "path" must have room for one more
+/// byte. The first "?" or "#" and the rest of the path are omitted, repeated
+/// "/" are collapsed into one, and trailing "/" are removed.
+/// "flags":
+/// xxxx xxx1 - Percent-encoded bytes are decoded.
+/// xxxx xx1x - A ".." segment is an error.
+/// Returns zero on success, 1 if an escape is invalid or decodes to NUL, or 2
+/// if there is a ".." segment.
+int c_simple_http_normalize_path(char *path, size_t *size, uint32_t flags);
+
 /// Takes a PATH string and returns a "bare" path.
 /// This will simply omit the first instance of "?" or "#" and the rest of the
 /// string. This will also remove trailing "/" characters.
 /// Must be free'd if returns non-NULL.
 char *c_simple_http_strip_path(const char *path, size_t path_size);
 
-/// Returns non-NULL if successful. Must be freed with
-/// simple_archiver_hash_map_free if non-NULL.
-/// The map is a mapping of lowercase header names to header lines.
-/// E.g. "user-agent" -> "User-Agent: curl".
-SDArchiverHashMap *c_simple_http_request_to_headers_map(
-  const char *request, size_t request_size);
+/// Returns non-zero if a "/" separated segment of "path" is "..".
+int c_simple_http_path_has_dot_dot(const char *path);
+
+/// Returns which known header "name" is (compared case insensitively,
+/// "name_size" not including any NUL), or C_SIMPLE_HTTP_KnownHeader_Unknown.
+enum C_SIMPLE_HTTP_KnownHeader c_simple_http_known_header(const char *name,
+                                                          size_t name_size);
+
+/// Returns the first header "known" of "request", or NULL if there is none.
+const C_SIMPLE_HTTP_Header *c_simple_http_request_known_header(
+  const C_SIMPLE_HTTP_ParsedRequest *request,
+  enum C_SIMPLE_HTTP_KnownHeader known);
+
+/// Returns the first header of "request" named "name" (compared case
+/// insensitively, "name_size" not including any NUL), or NULL if there is none.
+/// Known headers are looked up in their slot.
+const C_SIMPLE_HTTP_Header *c_simple_http_request_get_header(
+  const C_SIMPLE_HTTP_ParsedRequest *request,
+  const char *name,
+  size_t name_size);
+
+/// Returns the size of the first request in "request" up to and including the
+/// empty line ending its headers ("\r\n\r\n" or "\n\n"), or zero if the end of
+/// the headers was not found.
+/// If "scan_idx" is non-NULL, the search starts from "*scan_idx", and if the
+/// end was not found it is set to where the search should resume once more of
+/// the request is received.
+size_t c_simple_http_request_headers_end(const char *request,
+                                         size_t size,
+                                         size_t *scan_idx);
+
+/// Returns non-zero if the "Connection" header of "request" has the "close"
+/// option, or if "request" is HTTP/1.0 without the "keep-alive" option.
+int c_simple_http_request_connection_close(
+  const C_SIMPLE_HTTP_ParsedRequest *request);
 
 #endif
 
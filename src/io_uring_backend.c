@@ -0,0 +1,859 @@
+// ISC License
+// 
+// Copyright (c) 2026 Stephen Seo
+// 
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "io_uring_backend.h"
+
+#ifdef C_SIMPLE_HTTP_IO_URING_SUPPORTED
+
+// Standard library includes.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Linux/Unix includes.
+#include <linux/io_uring.h>
+#include <linux/time_types.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+
+// Local includes.
+#include "constants.h"
+#include "globals.h"
+#include "listener.h"
+
+// user_data values for operations not tied to a connection. Accepts are
+// tagged with C_SIMPLE_HTTP_IO_URING_TAG_ACCEPT plus the listener's index.
+#define C_SIMPLE_HTTP_IO_URING_TAG_WAKEUP 2
+#define C_SIMPLE_HTTP_IO_URING_TAG_INOTIFY 3
+#define C_SIMPLE_HTTP_IO_URING_TAG_CANCEL 4
+#define C_SIMPLE_HTTP_IO_URING_TAG_ACCEPT 8
+#define C_SIMPLE_HTTP_IO_URING_TAG_MAX \
+  (C_SIMPLE_HTTP_IO_URING_TAG_ACCEPT + C_SIMPLE_HTTP_LISTENERS_MAX - 1)
+
+// Connection operations are tagged with the ConnectionItem pointer ORed with
+// one of these.
+#define C_SIMPLE_HTTP_IO_URING_OP_RECV 1
+#define C_SIMPLE_HTTP_IO_URING_OP_SEND 2
+#define C_SIMPLE_HTTP_IO_URING_OP_CLOSE 3
+#define C_SIMPLE_HTTP_IO_URING_OP_MASK 7
+
+typedef struct C_SIMPLE_HTTP_IOUring {
+  int ring_fd;
+  // xxxx xxx1 - cq ring shares the mapping of the sq ring.
+  // xxxx xx1x - accepts fill in the peer's address (for logging or the rate
+  //             limiter), and are not multishot.
+  uint32_t flags;
+  void *sq_ring;
+  size_t sq_ring_size;
+  void *cq_ring;
+  size_t cq_ring_size;
+  struct io_uring_sqe *sqes;
+  size_t sqes_size;
+  uint32_t *sq_head;
+  uint32_t *sq_tail;
+  uint32_t sq_mask;
+  uint32_t sq_entries;
+  // Tail of sqes prepared but not yet published to the kernel.
+  uint32_t sqe_tail;
+  // Number of published sqes not yet passed to io_uring_enter.
+  uint32_t to_submit;
+  uint32_t *cq_head;
+  uint32_t *cq_tail;
+  uint32_t cq_mask;
+  struct io_uring_cqe *cqes;
+  // Provided buffers that recv operations are completed into.
+  struct io_uring_buf_ring *buf_ring;
+  size_t buf_ring_size;
+  char *bufs;
+  uint16_t buf_ring_tail;
+  // Counts the buffers recycled, to tell if any were since "bufs_rearmed".
+  uint32_t bufs_recycled;
+  uint32_t bufs_rearmed;
+  // Number of connections whose recv is waiting for buffers (flag 0x80).
+  uint32_t bufs_waiting;
+  // Where each listener's accept writes the peer's address.
+  struct sockaddr_storage accept_addrs[C_SIMPLE_HTTP_LISTENERS_MAX];
+  socklen_t accept_addr_sizes[C_SIMPLE_HTTP_LISTENERS_MAX];
+} C_SIMPLE_HTTP_IOUring;
+
+int c_simple_http_io_uring_is_supported(void) {
+  return 1;
+}
+
+int c_simple_http_internal_io_uring_enter(int ring_fd,
+                                          uint32_t to_submit,
+                                          uint32_t min_complete,
+                                          uint32_t flags,
+                                          void *arg,
+                                          size_t arg_size) {
+  return (int)syscall(__NR_io_uring_enter,
+                      ring_fd,
+                      to_submit,
+                      min_complete,
+                      flags,
+                      arg,
+                      arg_size);
+}
+
+void c_simple_http_internal_io_uring_publish(C_SIMPLE_HTTP_IOUring *ring) {
+  uint32_t tail = *ring->sq_tail;
+  if (tail != ring->sqe_tail) {
+    ring->to_submit += ring->sqe_tail - tail;
+    __atomic_store_n(ring->sq_tail, ring->sqe_tail, __ATOMIC_RELEASE);
+  }
+}
+
+/// Submits all prepared sqes without waiting. Returns zero on success.
+int c_simple_http_internal_io_uring_submit(C_SIMPLE_HTTP_IOUring *ring) {
+  c_simple_http_internal_io_uring_publish(ring);
+  while (ring->to_submit != 0) {
+    int ret = c_simple_http_internal_io_uring_enter(
+      ring->ring_fd, ring->to_submit, 0, 0, NULL, 0);
+    if (ret < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      fprintf(stderr, "ERROR io_uring submit failed! (errno %d)\n", errno);
+      return 1;
+    }
+    ring->to_submit -= (uint32_t)ret;
+  }
+  return 0;
+}
+
+/// Returns a zeroed sqe, or NULL if the submission queue could not be made
+/// available.
+struct io_uring_sqe *c_simple_http_internal_io_uring_get_sqe(
+    C_SIMPLE_HTTP_IOUring *ring) {
+  if (ring->sqe_tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE)
+      >= ring->sq_entries) {
+    if (c_simple_http_internal_io_uring_submit(ring) != 0) {
+      return NULL;
+    }
+  }
+
+  struct io_uring_sqe *sqe = &ring->sqes[ring->sqe_tail & ring->sq_mask];
+  memset(sqe, 0, sizeof(struct io_uring_sqe));
+  ++ring->sqe_tail;
+  return sqe;
+}
+
+uint64_t c_simple_http_internal_io_uring_citem_data(ConnectionItem *citem,
+                                                    uint64_t op) {
+  return (uint64_t)(uintptr_t)citem | op;
+}
+
+void c_simple_http_internal_io_uring_recycle_buf(C_SIMPLE_HTTP_IOUring *ring,
+                                                 uint16_t bid) {
+  struct io_uring_buf *buf = &ring->buf_ring->bufs[
+    ring->buf_ring_tail & (C_SIMPLE_HTTP_IO_URING_BUF_COUNT - 1)];
+  // "resv" of the first entry overlaps the ring's tail, so only these fields
+  // are set.
+  buf->addr = (uint64_t)(uintptr_t)(ring->bufs
+                                    + (size_t)bid
+                                      * C_SIMPLE_HTTP_RECV_BUF_SIZE);
+  buf->len = C_SIMPLE_HTTP_RECV_BUF_SIZE;
+  buf->bid = bid;
+  ++ring->buf_ring_tail;
+  ++ring->bufs_recycled;
+  __atomic_store_n(&ring->buf_ring->tail,
+                   ring->buf_ring_tail,
+                   __ATOMIC_RELEASE);
+}
+
+void c_simple_http_internal_io_uring_cleanup(C_SIMPLE_HTTP_IOUring *ring) {
+  if (ring->ring_fd >= 0) {
+    // Closing the ring cancels all of its pending operations.
+    close(ring->ring_fd);
+    ring->ring_fd = -1;
+  }
+  if (ring->sqes) {
+    munmap(ring->sqes, ring->sqes_size);
+    ring->sqes = NULL;
+  }
+  if (ring->cq_ring && (ring->flags & 1) == 0) {
+    munmap(ring->cq_ring, ring->cq_ring_size);
+  }
+  ring->cq_ring = NULL;
+  if (ring->sq_ring) {
+    munmap(ring->sq_ring, ring->sq_ring_size);
+    ring->sq_ring = NULL;
+  }
+  if (ring->buf_ring) {
+    munmap(ring->buf_ring, ring->buf_ring_size);
+    ring->buf_ring = NULL;
+  }
+  if (ring->bufs) {
+    free(ring->bufs);
+    ring->bufs = NULL;
+  }
+}
+
+/// Returns zero on success.
+int c_simple_http_internal_io_uring_setup(C_SIMPLE_HTTP_IOUring *ring) {
+  memset(ring, 0, sizeof(C_SIMPLE_HTTP_IOUring));
+
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(struct io_uring_params));
+  ring->ring_fd = (int)syscall(__NR_io_uring_setup,
+                               C_SIMPLE_HTTP_IO_URING_ENTRIES,
+                               &params);
+  if (ring->ring_fd < 0) {
+    fprintf(stderr, "ERROR Failed to set up io_uring! (errno %d)\n", errno);
+    return 1;
+  } else if ((params.features & IORING_FEAT_EXT_ARG) == 0
+      || (params.features & IORING_FEAT_NODROP) == 0) {
+    fprintf(stderr, "ERROR io_uring of this kernel is too old!\n");
+    return 1;
+  }
+
+  ring->sq_ring_size = params.sq_off.array
+    + params.sq_entries * sizeof(uint32_t);
+  ring->cq_ring_size = params.cq_off.cqes
+    + params.cq_entries * sizeof(struct io_uring_cqe);
+  if ((params.features & IORING_FEAT_SINGLE_MMAP) != 0) {
+    ring->flags |= 1;
+    if (ring->cq_ring_size > ring->sq_ring_size) {
+      ring->sq_ring_size = ring->cq_ring_size;
+    }
+  }
+
+  ring->sq_ring = mmap(NULL,
+                       ring->sq_ring_size,
+                       PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE,
+                       ring->ring_fd,
+                       IORING_OFF_SQ_RING);
+  if (ring->sq_ring == MAP_FAILED) {
+    ring->sq_ring = NULL;
+    fprintf(stderr, "ERROR Failed to map io_uring sq! (errno %d)\n", errno);
+    return 1;
+  }
+
+  if ((ring->flags & 1) != 0) {
+    ring->cq_ring = ring->sq_ring;
+  } else {
+    ring->cq_ring = mmap(NULL,
+                         ring->cq_ring_size,
+                         PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE,
+                         ring->ring_fd,
+                         IORING_OFF_CQ_RING);
+    if (ring->cq_ring == MAP_FAILED) {
+      ring->cq_ring = NULL;
+      fprintf(stderr, "ERROR Failed to map io_uring cq! (errno %d)\n", errno);
+      return 1;
+    }
+  }
+
+  ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+  ring->sqes = mmap(NULL,
+                    ring->sqes_size,
+                    PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE,
+                    ring->ring_fd,
+                    IORING_OFF_SQES);
+  if (ring->sqes == MAP_FAILED) {
+    ring->sqes = NULL;
+    fprintf(stderr, "ERROR Failed to map io_uring sqes! (errno %d)\n", errno);
+    return 1;
+  }
+
+  char *sq_ring = ring->sq_ring;
+  ring->sq_head = (uint32_t *)(sq_ring + params.sq_off.head);
+  ring->sq_tail = (uint32_t *)(sq_ring + params.sq_off.tail);
+  ring->sq_mask = *(uint32_t *)(sq_ring + params.sq_off.ring_mask);
+  ring->sq_entries = params.sq_entries;
+  ring->sqe_tail = *ring->sq_tail;
+  // Each sq entry always refers to the sqe of the same index.
+  uint32_t *sq_array = (uint32_t *)(sq_ring + params.sq_off.array);
+  for (uint32_t idx = 0; idx < params.sq_entries; ++idx) {
+    sq_array[idx] = idx;
+  }
+
+  char *cq_ring = ring->cq_ring;
+  ring->cq_head = (uint32_t *)(cq_ring + params.cq_off.head);
+  ring->cq_tail = (uint32_t *)(cq_ring + params.cq_off.tail);
+  ring->cq_mask = *(uint32_t *)(cq_ring + params.cq_off.ring_mask);
+  ring->cqes = (struct io_uring_cqe *)(cq_ring + params.cq_off.cqes);
+
+  // Set up provided buffers for multishot recv.
+  ring->buf_ring_size =
+    C_SIMPLE_HTTP_IO_URING_BUF_COUNT * sizeof(struct io_uring_buf);
+  ring->buf_ring = mmap(NULL,
+                        ring->buf_ring_size,
+                        PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS,
+                        -1,
+                        0);
+  if (ring->buf_ring == MAP_FAILED) {
+    ring->buf_ring = NULL;
+    fprintf(stderr, "ERROR Failed to allocate io_uring buffer ring!\n");
+    return 1;
+  }
+  ring->bufs = malloc((size_t)C_SIMPLE_HTTP_IO_URING_BUF_COUNT
+                      * C_SIMPLE_HTTP_RECV_BUF_SIZE);
+  if (!ring->bufs) {
+    fprintf(stderr, "ERROR Failed to allocate io_uring buffers!\n");
+    return 1;
+  }
+
+  struct io_uring_buf_reg buf_reg;
+  memset(&buf_reg, 0, sizeof(struct io_uring_buf_reg));
+  buf_reg.ring_addr = (uint64_t)(uintptr_t)ring->buf_ring;
+  buf_reg.ring_entries = C_SIMPLE_HTTP_IO_URING_BUF_COUNT;
+  buf_reg.bgid = 0;
+  if (syscall(__NR_io_uring_register,
+              ring->ring_fd,
+              IORING_REGISTER_PBUF_RING,
+              &buf_reg,
+              1) != 0) {
+    fprintf(stderr,
+            "ERROR Failed to register io_uring buffer ring! (errno %d)\n",
+            errno);
+    return 1;
+  }
+
+  for (uint16_t bid = 0; bid < C_SIMPLE_HTTP_IO_URING_BUF_COUNT; ++bid) {
+    c_simple_http_internal_io_uring_recycle_buf(ring, bid);
+  }
+  ring->bufs_rearmed = ring->bufs_recycled;
+
+  return 0;
+}
+
+/// Returns zero on success.
+int c_simple_http_internal_io_uring_prep_accept(
+    C_SIMPLE_HTTP_IOUring *ring,
+    C_SIMPLE_HTTP_Listeners *listeners,
+    uint32_t listener_idx) {
+  struct io_uring_sqe *sqe = c_simple_http_internal_io_uring_get_sqe(ring);
+  if (!sqe) {
+    return 1;
+  }
+  sqe->opcode = IORING_OP_ACCEPT;
+  sqe->fd = listeners->listeners[listener_idx].fd;
+  sqe->accept_flags = SOCK_CLOEXEC;
+  if ((ring->flags & 2) != 0) {
+    // The address is written along with the accept, instead of with a
+    // getpeername per connection.
+    ring->accept_addr_sizes[listener_idx] = sizeof(struct sockaddr_storage);
+    sqe->addr = (uint64_t)(uintptr_t)&ring->accept_addrs[listener_idx];
+    sqe->addr2 = (uint64_t)(uintptr_t)&ring->accept_addr_sizes[listener_idx];
+  } else {
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+  }
+  sqe->user_data = C_SIMPLE_HTTP_IO_URING_TAG_ACCEPT + listener_idx;
+  listeners->listeners[listener_idx].flags |= 8;
+  return 0;
+}
+
+/// Returns zero on success.
+int c_simple_http_internal_io_uring_prep_poll(C_SIMPLE_HTTP_IOUring *ring,
+                                              int fd,
+                                              uint64_t tag) {
+  struct io_uring_sqe *sqe = c_simple_http_internal_io_uring_get_sqe(ring);
+  if (!sqe) {
+    return 1;
+  }
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = fd;
+  sqe->poll32_events = POLLIN;
+  sqe->len = IORING_POLL_ADD_MULTI;
+  sqe->user_data = tag;
+  return 0;
+}
+
+/// Returns zero on success.
+int c_simple_http_internal_io_uring_prep_recv(C_SIMPLE_HTTP_IOUring *ring,
+                                              ConnectionItem *citem) {
+  struct io_uring_sqe *sqe = c_simple_http_internal_io_uring_get_sqe(ring);
+  if (!sqe) {
+    return 1;
+  }
+  sqe->opcode = IORING_OP_RECV;
+  sqe->fd = citem->fd;
+  sqe->flags = IOSQE_BUFFER_SELECT;
+  sqe->buf_group = 0;
+  sqe->ioprio = IORING_RECV_MULTISHOT;
+  sqe->user_data = c_simple_http_internal_io_uring_citem_data(
+    citem, C_SIMPLE_HTTP_IO_URING_OP_RECV);
+  citem->flags |= 1;
+  return 0;
+}
+
+/// Returns zero on success.
+int c_simple_http_internal_io_uring_prep_send(C_SIMPLE_HTTP_IOUring *ring,
+                                              ConnectionItem *citem) {
+  struct msghdr *msg = c_simple_http_output_queue_to_msg(&citem->out);
+  if (!msg) {
+    return 1;
+  }
+  struct io_uring_sqe *sqe = c_simple_http_internal_io_uring_get_sqe(ring);
+  if (!sqe) {
+    return 1;
+  }
+  sqe->opcode = IORING_OP_SENDMSG;
+  sqe->fd = citem->fd;
+  sqe->addr = (uint64_t)(uintptr_t)msg;
+  sqe->len = 1;
+  sqe->msg_flags = MSG_NOSIGNAL;
+  sqe->user_data = c_simple_http_internal_io_uring_citem_data(
+    citem, C_SIMPLE_HTTP_IO_URING_OP_SEND);
+  citem->flags |= 2;
+  return 0;
+}
+
+/// Submits the close of the connection once none of its operations are
+/// in-flight.
+void c_simple_http_internal_io_uring_try_finish(C_SIMPLE_HTTP_IOUring *ring,
+                                                ConnectionItem *citem) {
+  if ((citem->flags & 0xB) != 0) {
+    // Still in-flight, or close already submitted.
+    return;
+  }
+
+  struct io_uring_sqe *sqe = c_simple_http_internal_io_uring_get_sqe(ring);
+  if (!sqe) {
+    return;
+  }
+  sqe->opcode = IORING_OP_CLOSE;
+  sqe->fd = citem->fd;
+  sqe->user_data = c_simple_http_internal_io_uring_citem_data(
+    citem, C_SIMPLE_HTTP_IO_URING_OP_CLOSE);
+  citem->flags |= 8;
+}
+
+void c_simple_http_io_uring_close_connection(C_SIMPLE_HTTP_EventLoop *loop,
+                                             ConnectionItem *citem) {
+  C_SIMPLE_HTTP_IOUring *ring = loop->io_uring;
+  if (!ring || (citem->flags & 4) != 0) {
+    return;
+  }
+  citem->flags |= 4;
+
+  if ((citem->flags & 1) != 0) {
+    // Cancel only the recv, a pending send is allowed to finish.
+    struct io_uring_sqe *sqe = c_simple_http_internal_io_uring_get_sqe(ring);
+    if (sqe) {
+      sqe->opcode = IORING_OP_ASYNC_CANCEL;
+      sqe->fd = -1;
+      sqe->addr = c_simple_http_internal_io_uring_citem_data(
+        citem, C_SIMPLE_HTTP_IO_URING_OP_RECV);
+      sqe->user_data = C_SIMPLE_HTTP_IO_URING_TAG_CANCEL;
+    }
+  }
+
+  c_simple_http_internal_io_uring_try_finish(ring, citem);
+}
+
+void c_simple_http_io_uring_abort_connection(C_SIMPLE_HTTP_EventLoop *loop,
+                                             ConnectionItem *citem) {
+  C_SIMPLE_HTTP_IOUring *ring = loop->io_uring;
+  if (!ring) {
+    return;
+  }
+  c_simple_http_io_uring_close_connection(loop, citem);
+
+  if ((citem->flags & 2) != 0) {
+    // A peer that stopped reading would keep the send in-flight forever.
+    struct io_uring_sqe *sqe = c_simple_http_internal_io_uring_get_sqe(ring);
+    if (sqe) {
+      sqe->opcode = IORING_OP_ASYNC_CANCEL;
+      sqe->fd = -1;
+      sqe->addr = c_simple_http_internal_io_uring_citem_data(
+        citem, C_SIMPLE_HTTP_IO_URING_OP_SEND);
+      sqe->user_data = C_SIMPLE_HTTP_IO_URING_TAG_CANCEL;
+    }
+  }
+}
+
+void c_simple_http_io_uring_stop_accepting(C_SIMPLE_HTTP_EventLoop *loop) {
+  C_SIMPLE_HTTP_IOUring *ring = loop->io_uring;
+  for (uint32_t idx = 0; ring && idx < loop->listeners->count; ++idx) {
+    struct io_uring_sqe *sqe = c_simple_http_internal_io_uring_get_sqe(ring);
+    if (sqe) {
+      sqe->opcode = IORING_OP_ASYNC_CANCEL;
+      sqe->fd = -1;
+      sqe->addr = C_SIMPLE_HTTP_IO_URING_TAG_ACCEPT + idx;
+      sqe->user_data = C_SIMPLE_HTTP_IO_URING_TAG_CANCEL;
+    }
+  }
+}
+
+void c_simple_http_io_uring_resume_accepting(C_SIMPLE_HTTP_EventLoop *loop) {
+  C_SIMPLE_HTTP_IOUring *ring = loop->io_uring;
+  for (uint32_t idx = 0; ring && idx < loop->listeners->count; ++idx) {
+    // A cancelled accept that did not complete yet is re-armed when it does.
+    if ((loop->listeners->listeners[idx].flags & 8) == 0
+        && c_simple_http_internal_io_uring_prep_accept(ring,
+                                                       loop->listeners,
+                                                       idx) != 0) {
+      fprintf(stderr, "WARNING Failed to accept again on a listener!\n");
+    }
+  }
+}
+
+/// Returns non-zero if the program should stop with that error code.
+int c_simple_http_internal_io_uring_handle_accept(
+    C_SIMPLE_HTTP_EventLoop *loop,
+    const struct io_uring_cqe *cqe) {
+  C_SIMPLE_HTTP_IOUring *ring = loop->io_uring;
+  const uint32_t listener_idx =
+    (uint32_t)(cqe->user_data - C_SIMPLE_HTTP_IO_URING_TAG_ACCEPT);
+
+  if (cqe->res >= 0) {
+    int connection_fd = cqe->res;
+    struct in6_addr peer_addr;
+    if ((ring->flags & 2) != 0) {
+      c_simple_http_listener_peer_to_ipv6(&ring->accept_addrs[listener_idx],
+                                          &peer_addr);
+    } else {
+      // Not logged nor rate limited, so it is left unspecified.
+      memset(&peer_addr, 0, sizeof(struct in6_addr));
+    }
+
+    ConnectionItem *citem = c_simple_http_event_loop_add_connection(
+      loop, connection_fd, &peer_addr);
+    if (citem && c_simple_http_internal_io_uring_prep_recv(ring, citem) != 0) {
+      c_simple_http_event_loop_remove_connection(loop, citem);
+    }
+  } else if (cqe->res == -EINVAL) {
+    fprintf(stderr,
+            "ERROR io_uring %s is not supported by this kernel!\n",
+            (ring->flags & 2) != 0 ? "accept" : "multishot accept");
+    return 1;
+  } else if (cqe->res != -ECANCELED) {
+    printf("WARNING: accept: errno %d\n", -cqe->res);
+  }
+
+  if ((cqe->flags & IORING_CQE_F_MORE) == 0) {
+    loop->listeners->listeners[listener_idx].flags &= ~(uint32_t)8;
+    // Not re-armed while draining or overloaded.
+    if ((loop->flags & 0x48) == 0
+        && c_simple_http_internal_io_uring_prep_accept(ring,
+                                                       loop->listeners,
+                                                       listener_idx)
+           != 0) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+/// Handles received requests and sends their responses.
+void c_simple_http_internal_io_uring_handle_input(C_SIMPLE_HTTP_EventLoop *loop,
+                                                  ConnectionItem *citem,
+                                                  char *buf,
+                                                  size_t size) {
+  int ret = c_simple_http_connection_handle_input(citem, loop->ctx, buf, size);
+  if (citem->out.size != 0
+      && c_simple_http_internal_io_uring_prep_send(loop->io_uring, citem)
+         != 0) {
+    ret = 1;
+  }
+  if (ret != 0) {
+    c_simple_http_io_uring_close_connection(loop, citem);
+  }
+}
+
+void c_simple_http_internal_io_uring_handle_recv(
+    C_SIMPLE_HTTP_EventLoop *loop,
+    ConnectionItem *citem,
+    const struct io_uring_cqe *cqe) {
+  C_SIMPLE_HTTP_IOUring *ring = loop->io_uring;
+
+  if ((cqe->flags & IORING_CQE_F_MORE) == 0) {
+    citem->flags &= ~(uint32_t)1;
+  }
+
+  if (cqe->res > 0) {
+    uint16_t bid = (uint16_t)(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+    char *buf = ring->bufs + (size_t)bid * C_SIMPLE_HTTP_RECV_BUF_SIZE;
+    if ((citem->flags & 6) == 2) {
+      // The previous responses are still being sent, and "citem->out" must
+      // not be modified until it is done, so the requests are handled after.
+      if (citem->in.size + (size_t)cqe->res > C_SIMPLE_HTTP_MAX_REQUEST_SIZE
+          || c_simple_http_buffer_append(&citem->in, buf, (size_t)cqe->res)
+             != 0) {
+        c_simple_http_io_uring_close_connection(loop, citem);
+      }
+    } else if ((citem->flags & 4) == 0) {
+      c_simple_http_internal_io_uring_handle_input(loop, citem, buf,
+                                                   (size_t)cqe->res);
+    }
+    c_simple_http_internal_io_uring_recycle_buf(ring, bid);
+  } else if (cqe->res == -ENOBUFS) {
+    // All provided buffers are in use, the recv is submitted again once some
+    // are recycled (see c_simple_http_internal_io_uring_rearm_recvs).
+    if ((citem->flags & 5) == 0) {
+      if ((citem->flags & 0x80) == 0) {
+        citem->flags |= 0x80;
+        ++ring->bufs_waiting;
+      }
+      return;
+    }
+  } else if (cqe->res < 0 && cqe->res != -ECANCELED) {
+    fprintf(stderr, "Peer ");
+    c_simple_http_print_ipv6_addr(stderr, &citem->peer_addr);
+    fprintf(stderr, " error.\n");
+    c_simple_http_io_uring_close_connection(loop, citem);
+  } else {
+    // Peer closed the connection, or the recv was cancelled.
+    c_simple_http_io_uring_close_connection(loop, citem);
+  }
+
+  c_simple_http_internal_io_uring_try_finish(ring, citem);
+}
+
+void c_simple_http_internal_io_uring_handle_send(
+    C_SIMPLE_HTTP_EventLoop *loop,
+    ConnectionItem *citem,
+    const struct io_uring_cqe *cqe) {
+  C_SIMPLE_HTTP_IOUring *ring = loop->io_uring;
+  citem->flags &= ~(uint32_t)2;
+
+  if (cqe->res == -ECANCELED) {
+    // Aborted, see c_simple_http_io_uring_abort_connection().
+  } else if (cqe->res < 0) {
+    fprintf(stderr, "ERROR Failed to write to connected peer, closing...\n");
+  } else {
+    c_simple_http_output_queue_consume(&citem->out, (size_t)cqe->res);
+    // Sending made progress, so the connection is not idle.
+    citem->time_point = loop->ctx->current_time;
+    if (citem->out.size != 0) {
+      if (c_simple_http_internal_io_uring_prep_send(ring, citem) == 0) {
+        return;
+      }
+    } else if ((citem->flags & 4) == 0) {
+      if (citem->in.size != 0) {
+        // Handle requests received while sending.
+        c_simple_http_internal_io_uring_handle_input(loop, citem, NULL, 0);
+      }
+      c_simple_http_internal_io_uring_try_finish(ring, citem);
+      return;
+    }
+  }
+
+  c_simple_http_io_uring_close_connection(loop, citem);
+  c_simple_http_internal_io_uring_try_finish(ring, citem);
+}
+
+/// Submits the recvs that were waiting for provided buffers, if any buffers
+/// were recycled since the last time. Called after handling completions, as
+/// they return their buffers.
+void c_simple_http_internal_io_uring_rearm_recvs(
+    C_SIMPLE_HTTP_EventLoop *loop) {
+  C_SIMPLE_HTTP_IOUring *ring = loop->io_uring;
+  if (ring->bufs_waiting == 0 || ring->bufs_recycled == ring->bufs_rearmed) {
+    return;
+  }
+  ring->bufs_waiting = 0;
+  ring->bufs_rearmed = ring->bufs_recycled;
+
+  // Rare enough that going over every connection is cheaper than tracking
+  // the waiting ones.
+  for (uint32_t idx = 0; idx < loop->connections.capacity; ++idx) {
+    ConnectionItem *citem = &loop->connections.items[idx];
+    if ((citem->flags & 0x80) == 0) {
+      continue;
+    }
+    citem->flags &= ~(uint32_t)0x80;
+    if ((citem->flags & 5) == 0
+        && c_simple_http_internal_io_uring_prep_recv(ring, citem) != 0) {
+      c_simple_http_io_uring_close_connection(loop, citem);
+    }
+  }
+}
+
+/// Returns non-zero if the program should stop with that error code.
+int c_simple_http_internal_io_uring_handle_cqe(C_SIMPLE_HTTP_EventLoop *loop,
+                                               const struct io_uring_cqe *cqe) {
+  C_SIMPLE_HTTP_IOUring *ring = loop->io_uring;
+
+  if (cqe->user_data >= C_SIMPLE_HTTP_IO_URING_TAG_ACCEPT
+      && cqe->user_data <= C_SIMPLE_HTTP_IO_URING_TAG_MAX) {
+    return c_simple_http_internal_io_uring_handle_accept(loop, cqe);
+  } else if (cqe->user_data <= C_SIMPLE_HTTP_IO_URING_TAG_MAX) {
+    switch (cqe->user_data) {
+      case C_SIMPLE_HTTP_IO_URING_TAG_WAKEUP:
+        c_simple_http_event_loop_handle_wakeup(loop);
+        if ((cqe->flags & IORING_CQE_F_MORE) == 0) {
+          return c_simple_http_internal_io_uring_prep_poll(
+            ring, loop->wakeup_fd, C_SIMPLE_HTTP_IO_URING_TAG_WAKEUP);
+        }
+        break;
+      case C_SIMPLE_HTTP_IO_URING_TAG_INOTIFY:
+        c_simple_http_event_loop_handle_inotify(loop);
+        if ((cqe->flags & IORING_CQE_F_MORE) == 0) {
+          return c_simple_http_internal_io_uring_prep_poll(
+            ring, loop->inotify_fd, C_SIMPLE_HTTP_IO_URING_TAG_INOTIFY);
+        }
+        break;
+      default:
+        break;
+    }
+    return 0;
+  }
+
+  ConnectionItem *citem = (ConnectionItem *)(uintptr_t)(
+    cqe->user_data & ~(uint64_t)C_SIMPLE_HTTP_IO_URING_OP_MASK);
+  switch (cqe->user_data & C_SIMPLE_HTTP_IO_URING_OP_MASK) {
+    case C_SIMPLE_HTTP_IO_URING_OP_RECV:
+      c_simple_http_internal_io_uring_handle_recv(loop, citem, cqe);
+      break;
+    case C_SIMPLE_HTTP_IO_URING_OP_SEND:
+      c_simple_http_internal_io_uring_handle_send(loop, citem, cqe);
+      break;
+    case C_SIMPLE_HTTP_IO_URING_OP_CLOSE:
+      // The fd is closed (or invalid), and flag 8 keeps it from being closed
+      // again.
+      c_simple_http_event_loop_remove_connection(loop, citem);
+      break;
+    default:
+      break;
+  }
+
+  return 0;
+}
+
+int c_simple_http_io_uring_run(C_SIMPLE_HTTP_EventLoop *loop) {
+  __attribute__((cleanup(c_simple_http_internal_io_uring_cleanup)))
+  C_SIMPLE_HTTP_IOUring ring;
+  if (c_simple_http_internal_io_uring_setup(&ring) != 0) {
+    return 1;
+  }
+  loop->io_uring = &ring;
+  if ((loop->ctx->args->flags & 1) == 0 || loop->ctx->rate_limiter) {
+    ring.flags |= 2;
+  }
+
+  int ret = 0;
+  for (uint32_t idx = 0; ret == 0 && idx < loop->listeners->count; ++idx) {
+    ret = c_simple_http_internal_io_uring_prep_accept(&ring,
+                                                      loop->listeners,
+                                                      idx);
+  }
+  if (ret == 0 && loop->inotify_fd >= 0) {
+    ret = c_simple_http_internal_io_uring_prep_poll(
+      &ring, loop->inotify_fd, C_SIMPLE_HTTP_IO_URING_TAG_INOTIFY);
+  }
+  if (ret == 0 && loop->wakeup_fd >= 0) {
+    ret = c_simple_http_internal_io_uring_prep_poll(
+      &ring, loop->wakeup_fd, C_SIMPLE_HTTP_IO_URING_TAG_WAKEUP);
+  }
+  if (ret != 0) {
+    loop->io_uring = NULL;
+    return 1;
+  }
+
+  struct __kernel_timespec timeout;
+  struct io_uring_getevents_arg getevents_arg;
+
+  while (C_SIMPLE_HTTP_KEEP_RUNNING
+      && !c_simple_http_event_loop_drained(loop)) {
+    int timeout_millis = c_simple_http_event_loop_next_timeout(loop);
+    memset(&getevents_arg, 0, sizeof(struct io_uring_getevents_arg));
+    if (timeout_millis >= 0) {
+      timeout.tv_sec = timeout_millis / 1000;
+      timeout.tv_nsec = (long long)(timeout_millis % 1000) * 1000000;
+      getevents_arg.ts = (uint64_t)(uintptr_t)&timeout;
+    }
+
+    c_simple_http_internal_io_uring_publish(&ring);
+    ret = c_simple_http_internal_io_uring_enter(
+      ring.ring_fd,
+      ring.to_submit,
+      1,
+      IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+      &getevents_arg,
+      sizeof(struct io_uring_getevents_arg));
+    if (ret >= 0) {
+      ring.to_submit -= (uint32_t)ret;
+    } else if (errno != EINTR && errno != ETIME && errno != EBUSY) {
+      fprintf(stderr, "ERROR io_uring_enter failed! (errno %d)\n", errno);
+      loop->io_uring = NULL;
+      return 1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &loop->ctx->current_time);
+
+    uint32_t head = *ring.cq_head;
+    while (head != __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE)) {
+      struct io_uring_cqe cqe = ring.cqes[head & ring.cq_mask];
+      ++head;
+      __atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+      ret = c_simple_http_internal_io_uring_handle_cqe(loop, &cqe);
+      if (ret != 0) {
+        loop->io_uring = NULL;
+        return ret;
+      }
+    }
+    c_simple_http_internal_io_uring_rearm_recvs(loop);
+
+    ret = c_simple_http_event_loop_do_tasks(loop);
+    if (ret != 0) {
+      loop->io_uring = NULL;
+      return ret;
+    }
+  }
+
+  loop->io_uring = NULL;
+  return 0;
+}
+
+#else
+
+// Standard library includes.
+#include <stdio.h>
+
+int c_simple_http_io_uring_is_supported(void) {
+  return 0;
+}
+
+int c_simple_http_io_uring_run(
+    __attribute__((unused)) C_SIMPLE_HTTP_EventLoop *loop) {
+  fprintf(stderr, "ERROR io_uring backend was not compiled in!\n");
+  return 1;
+}
+
+void c_simple_http_io_uring_stop_accepting(
+    __attribute__((unused)) C_SIMPLE_HTTP_EventLoop *loop) {
+}
+
+void c_simple_http_io_uring_resume_accepting(
+    __attribute__((unused)) C_SIMPLE_HTTP_EventLoop *loop) {
+}
+
+void c_simple_http_io_uring_close_connection(
+    __attribute__((unused)) C_SIMPLE_HTTP_EventLoop *loop,
+    __attribute__((unused)) ConnectionItem *citem) {
+}
+
+void c_simple_http_io_uring_abort_connection(
+    __attribute__((unused)) C_SIMPLE_HTTP_EventLoop *loop,
+    __attribute__((unused)) ConnectionItem *citem) {
+}
+
+#endif
+
+// vim: et ts=2 sts=2 sw=2
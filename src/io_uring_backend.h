@@ -0,0 +1,61 @@
+// ISC License
+// 
+// Copyright (c) 2026 Stephen Seo
+// 
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef SEODISPARATE_COM_C_SIMPLE_HTTP_IO_URING_BACKEND_H_
+#define SEODISPARATE_COM_C_SIMPLE_HTTP_IO_URING_BACKEND_H_
+
+// The io_uring backend is compiled in only if the kernel headers provide it,
+// and may be explicitly left out by defining C_SIMPLE_HTTP_DISABLE_IO_URING.
+#if !defined(C_SIMPLE_HTTP_DISABLE_IO_URING) && defined(__has_include)
+# if __has_include(<linux/io_uring.h>)
+#  define C_SIMPLE_HTTP_IO_URING_SUPPORTED
+# endif
+#endif
+
+// Local includes.
+#include "connection.h"
+#include "event_loop.h"
+
+/// Returns non-zero if the io_uring backend was compiled in.
+int c_simple_http_io_uring_is_supported(void);
+
+/// Runs the event loop with io_uring instead of epoll. Accepts, receives,
+/// sends, and closes are all submitted as io_uring operations.
+/// Returns zero on normal exit, and non-zero if the program should exit with
+/// that error code.
+int c_simple_http_io_uring_run(C_SIMPLE_HTTP_EventLoop *loop);
+
+/// Cancels the accepts on the loop's listeners.
+void c_simple_http_io_uring_stop_accepting(C_SIMPLE_HTTP_EventLoop *loop);
+
+/// Accepts again on the loop's listeners after
+/// c_simple_http_io_uring_stop_accepting().
+void c_simple_http_io_uring_resume_accepting(C_SIMPLE_HTTP_EventLoop *loop);
+
+/// Stops receiving on the connection and closes it once its pending send (if
+/// any) is done. The ConnectionItem is removed from the loop after the close
+/// completes.
+void c_simple_http_io_uring_close_connection(C_SIMPLE_HTTP_EventLoop *loop,
+                                             ConnectionItem *citem);
+
+/// Like c_simple_http_io_uring_close_connection(), but also cancels the
+/// pending send (if any) instead of waiting for it to finish.
+void c_simple_http_io_uring_abort_connection(C_SIMPLE_HTTP_EventLoop *loop,
+                                             ConnectionItem *citem);
+
+#endif
+
+// vim: et ts=2 sts=2 sw=2
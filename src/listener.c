@@ -0,0 +1,680 @@
+// ISC License
+// 
+// Copyright (c) 2024-2025 Stephen Seo
+// 
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+
+#include "listener.h"
+
+// Standard library includes.
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+// Unix includes.
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Local includes.
+#include "big_endian.h"
+
+int c_simple_http_listener_parse_addr(const char *str,
+                                      uint16_t default_port,
+                                      struct sockaddr_storage *addr_out,
+                                      socklen_t *addr_len_out) {
+  memset(addr_out, 0, sizeof(struct sockaddr_storage));
+
+  if (strncmp(str, "unix:", 5) == 0) {
+    const char *path = str + 5;
+    const size_t path_len = strlen(path);
+    struct sockaddr_un *unix_addr = (struct sockaddr_un *)addr_out;
+    if (path_len == 0 || path_len >= sizeof(unix_addr->sun_path)) {
+      return 1;
+    }
+    unix_addr->sun_family = AF_UNIX;
+    memcpy(unix_addr->sun_path, path, path_len);
+    if (path[0] == '@') {
+      // Abstract socket, the name is not NUL terminated.
+      unix_addr->sun_path[0] = 0;
+      *addr_len_out =
+        (socklen_t)(offsetof(struct sockaddr_un, sun_path) + path_len);
+    } else {
+      *addr_len_out = sizeof(struct sockaddr_un);
+    }
+    return 0;
+  }
+
+  char host[INET6_ADDRSTRLEN];
+  size_t host_len;
+  const char *port_str = NULL;
+  int_fast8_t is_ipv6 = 0;
+  if (str[0] == '[') {
+    const char *host_end = strchr(str, ']');
+    if (!host_end) {
+      return 1;
+    }
+    host_len = (size_t)(host_end - str - 1);
+    if (host_end[1] == ':') {
+      port_str = host_end + 2;
+    } else if (host_end[1] != 0) {
+      return 1;
+    }
+    ++str;
+    is_ipv6 = 1;
+  } else {
+    const char *colon = strchr(str, ':');
+    if (colon) {
+      host_len = (size_t)(colon - str);
+      port_str = colon + 1;
+    } else {
+      host_len = strlen(str);
+    }
+  }
+  if (host_len == 0 || host_len >= sizeof(host)) {
+    return 1;
+  }
+  memcpy(host, str, host_len);
+  host[host_len] = 0;
+
+  uint16_t port = default_port;
+  if (port_str) {
+    char *port_end;
+    unsigned long value = strtoul(port_str, &port_end, 10);
+    if (port_str[0] < '0' || port_str[0] > '9' || *port_end != 0
+        || value > 0xFFFF) {
+      return 1;
+    }
+    port = (uint16_t)value;
+  }
+
+  if (is_ipv6) {
+    struct sockaddr_in6 *ipv6_addr = (struct sockaddr_in6 *)addr_out;
+    if (inet_pton(AF_INET6, host, &ipv6_addr->sin6_addr) != 1) {
+      return 1;
+    }
+    ipv6_addr->sin6_family = AF_INET6;
+    ipv6_addr->sin6_port = u16_be_swap(port);
+    *addr_len_out = sizeof(struct sockaddr_in6);
+  } else {
+    struct sockaddr_in *ipv4_addr = (struct sockaddr_in *)addr_out;
+    if (inet_pton(AF_INET, host, &ipv4_addr->sin_addr) != 1) {
+      return 1;
+    }
+    ipv4_addr->sin_family = AF_INET;
+    ipv4_addr->sin_port = u16_be_swap(port);
+    *addr_len_out = sizeof(struct sockaddr_in);
+  }
+
+  return 0;
+}
+
+int c_simple_http_listener_create(const struct sockaddr *addr,
+                                  socklen_t addr_len,
+                                  int_fast8_t reuse_port,
+                                  int_fast8_t v6_only,
+                                  const Args *args) {
+  const int_fast8_t is_unix = addr->sa_family == AF_UNIX ? 1 : 0;
+  int listen_socket = socket(addr->sa_family,
+                             SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                             0);
+  if (listen_socket == -1) {
+    switch (errno) {
+      case EACCES:
+        puts("ERROR: Socket creation: EACCES");
+        break;
+      case EAFNOSUPPORT:
+        puts("ERROR: Socket creation: EAFNOSUPPORT");
+        break;
+      case EINVAL:
+        puts("ERROR: Socket creation: EINVAL");
+        break;
+      case EMFILE:
+        puts("ERROR: Socket creation: EMFILE");
+        break;
+      case ENOBUFS:
+        puts("ERROR: Socket creation: ENOBUFS");
+        break;
+      case ENOMEM:
+        puts("ERROR: Socket creation: ENOMEM");
+        break;
+      case EPROTONOSUPPORT:
+        puts("ERROR: Socket creation: EPROTONOSUPPORT");
+        break;
+      default:
+        puts("ERROR: Socket creation: Unknown Error");
+        break;
+    }
+    return -1;
+  }
+
+  if (is_unix) {
+    const struct sockaddr_un *unix_addr = (const struct sockaddr_un *)addr;
+    struct stat unix_stat;
+    // Remove the socket file left behind by a previous run. Abstract sockets
+    // have no file.
+    if (unix_addr->sun_path[0] != 0
+        && stat(unix_addr->sun_path, &unix_stat) == 0
+        && S_ISSOCK(unix_stat.st_mode)) {
+      unlink(unix_addr->sun_path);
+    }
+  }
+
+  if (!is_unix && reuse_port) {
+    int value = 1;
+    if (setsockopt(listen_socket,
+                   SOL_SOCKET,
+                   SO_REUSEPORT,
+                   &value,
+                   sizeof(int)) != 0) {
+      close(listen_socket);
+      puts("ERROR: Failed to set SO_REUSEPORT on socket!");
+      return -1;
+    }
+  }
+
+  if (!is_unix && (args->flags & 0x20) != 0) {
+    int value = 1;
+    if (setsockopt(listen_socket,
+                   SOL_SOCKET,
+                   SO_REUSEADDR,
+                   &value,
+                   sizeof(int)) != 0) {
+      close(listen_socket);
+      puts("ERROR: Failed to set SO_REUSEADDR on socket!");
+      return -1;
+    }
+  }
+
+  if (addr->sa_family == AF_INET6) {
+    int value = v6_only ? 1 : 0;
+    if (setsockopt(listen_socket,
+                   IPPROTO_IPV6,
+                   IPV6_V6ONLY,
+                   &value,
+                   sizeof(int)) != 0) {
+      close(listen_socket);
+      puts("ERROR: Failed to set IPV6_V6ONLY on socket!");
+      return -1;
+    }
+  }
+
+  // The following are optimizations, so the socket is still usable if they
+  // fail.
+  if (!is_unix && args->tcp_defer_accept_seconds != 0) {
+    int value = (int)args->tcp_defer_accept_seconds;
+    if (setsockopt(listen_socket,
+                   IPPROTO_TCP,
+                   TCP_DEFER_ACCEPT,
+                   &value,
+                   sizeof(int)) != 0) {
+      puts("WARNING: Failed to set TCP_DEFER_ACCEPT on socket!");
+    }
+  }
+
+  if (!is_unix && args->tcp_fastopen_queue_length != 0) {
+    int value = (int)args->tcp_fastopen_queue_length;
+    if (setsockopt(listen_socket,
+                   IPPROTO_TCP,
+                   TCP_FASTOPEN,
+                   &value,
+                   sizeof(int)) != 0) {
+      puts("WARNING: Failed to set TCP_FASTOPEN on socket!");
+    }
+  }
+
+  int ret = bind(listen_socket, addr, addr_len);
+  if (ret != 0) {
+    close(listen_socket);
+    puts("ERROR: Failed to bind socket! (Maybe just attempted to reuse socket "
+         "that didn't get \"cleaned up\" yet? Use different port?)");
+    return -1;
+  }
+
+  ret = listen(listen_socket, (int)args->listen_backlog);
+
+  if (ret == 0) {
+    return listen_socket;
+  } else {
+    switch (errno) {
+      case EADDRINUSE:
+        puts("ERROR: Socket listen: EADDRINUSE");
+        break;
+      case EBADF:
+        puts("ERROR: Socket listen: EBADF");
+        break;
+      case ENOTSOCK:
+        puts("ERROR: Socket listen: ENOTSOCK");
+        break;
+      default:
+        puts("ERROR: Socket listen: Unknown Error");
+        break;
+    }
+
+    close(listen_socket);
+    return -1;
+  }
+}
+
+/// Returns non-zero if "listener" is bound to "addr". Port 0 in "addr"
+/// matches any port.
+int c_simple_http_internal_listener_matches(
+    const C_SIMPLE_HTTP_Listener *listener,
+    const struct sockaddr *addr,
+    socklen_t addr_len) {
+  if (listener->addr.ss_family != addr->sa_family) {
+    return 0;
+  }
+
+  switch (addr->sa_family) {
+    case AF_UNIX: {
+      const struct sockaddr_un *a = (const struct sockaddr_un *)addr;
+      const struct sockaddr_un *b =
+        (const struct sockaddr_un *)&listener->addr;
+      if (a->sun_path[0] != 0) {
+        return strncmp(a->sun_path, b->sun_path, sizeof(a->sun_path)) == 0;
+      }
+      // Abstract names are not NUL terminated.
+      return addr_len == listener->addr_len
+        && memcmp(a->sun_path,
+                  b->sun_path,
+                  addr_len - offsetof(struct sockaddr_un, sun_path)) == 0;
+    }
+    case AF_INET: {
+      const struct sockaddr_in *a = (const struct sockaddr_in *)addr;
+      const struct sockaddr_in *b =
+        (const struct sockaddr_in *)&listener->addr;
+      return a->sin_addr.s_addr == b->sin_addr.s_addr
+        && (a->sin_port == 0 || a->sin_port == b->sin_port);
+    }
+    case AF_INET6: {
+      const struct sockaddr_in6 *a = (const struct sockaddr_in6 *)addr;
+      const struct sockaddr_in6 *b =
+        (const struct sockaddr_in6 *)&listener->addr;
+      return memcmp(&a->sin6_addr, &b->sin6_addr, sizeof(struct in6_addr))
+          == 0
+        && (a->sin6_port == 0 || a->sin6_port == b->sin6_port);
+    }
+    default:
+      return 0;
+  }
+}
+
+/// Moves an inherited socket bound to "addr" to "listener_out".
+/// Returns zero if there was one.
+int c_simple_http_internal_listeners_claim(
+    C_SIMPLE_HTTP_InheritedListeners *inherited,
+    const struct sockaddr *addr,
+    socklen_t addr_len,
+    C_SIMPLE_HTTP_Listener *listener_out) {
+  if (!inherited) {
+    return 1;
+  }
+  for (uint32_t idx = 0; idx < inherited->count; ++idx) {
+    if (c_simple_http_internal_listener_matches(&inherited->listeners[idx],
+                                                addr,
+                                                addr_len)) {
+      *listener_out = inherited->listeners[idx];
+      inherited->listeners[idx] = inherited->listeners[--inherited->count];
+      return 0;
+    }
+  }
+  return 1;
+}
+
+int c_simple_http_internal_listeners_add(
+    C_SIMPLE_HTTP_Listeners *listeners,
+    C_SIMPLE_HTTP_InheritedListeners *inherited,
+    const struct sockaddr *addr,
+    socklen_t addr_len,
+    int_fast8_t reuse_port,
+    int_fast8_t v6_only,
+    const Args *args) {
+  if (listeners->count >= C_SIMPLE_HTTP_LISTENERS_MAX) {
+    fprintf(stderr,
+            "ERROR Too many listen addresses! (max %d)\n",
+            C_SIMPLE_HTTP_LISTENERS_MAX);
+    return 1;
+  }
+
+  C_SIMPLE_HTTP_Listener *listener = &listeners->listeners[listeners->count];
+  if (c_simple_http_internal_listeners_claim(inherited,
+                                             addr,
+                                             addr_len,
+                                             listener) == 0) {
+    ++listeners->count;
+    return 0;
+  }
+
+  listener->fd = c_simple_http_listener_create(addr,
+                                               addr_len,
+                                               reuse_port,
+                                               v6_only,
+                                               args);
+  if (listener->fd < 0) {
+    return 1;
+  }
+  ++listeners->count;
+  listener->flags = 1;
+
+  // Fetch the bound address so that port 0 resolves to the actual port.
+  listener->addr_len = sizeof(struct sockaddr_storage);
+  if (getsockname(listener->fd,
+                  (struct sockaddr *)&listener->addr,
+                  &listener->addr_len) != 0) {
+    memcpy(&listener->addr, addr, addr_len);
+    listener->addr_len = addr_len;
+  }
+  if (addr->sa_family == AF_UNIX
+      && ((const struct sockaddr_un *)addr)->sun_path[0] != 0) {
+    listener->flags |= 2;
+  }
+
+  return 0;
+}
+
+int c_simple_http_listeners_open(C_SIMPLE_HTTP_Listeners *listeners,
+                                 C_SIMPLE_HTTP_InheritedListeners *inherited,
+                                 const Args *args) {
+  memset(listeners, 0, sizeof(C_SIMPLE_HTTP_Listeners));
+  const int_fast8_t reuse_port = args->workers > 1 ? 1 : 0;
+
+  if (!args->listen_addrs || args->listen_addrs->count == 0) {
+    struct sockaddr_in6 ipv6_addr;
+    memset(&ipv6_addr, 0, sizeof(struct sockaddr_in6));
+    ipv6_addr.sin6_family = AF_INET6;
+    ipv6_addr.sin6_port = u16_be_swap(args->port);
+    ipv6_addr.sin6_addr = in6addr_any;
+    return c_simple_http_internal_listeners_add(
+      listeners,
+      inherited,
+      (const struct sockaddr *)&ipv6_addr,
+      sizeof(struct sockaddr_in6),
+      reuse_port,
+      0,
+      args);
+  }
+
+  for (SDArchiverLLNode *node = args->listen_addrs->head->next;
+      node != args->listen_addrs->tail;
+      node = node->next) {
+    struct sockaddr_storage addr;
+    socklen_t addr_len;
+    if (c_simple_http_listener_parse_addr(node->data,
+                                          args->port,
+                                          &addr,
+                                          &addr_len) != 0) {
+      fprintf(stderr,
+              "ERROR Invalid listen address \"%s\"!\n",
+              (const char *)node->data);
+      c_simple_http_listeners_cleanup(listeners);
+      return 1;
+    }
+    // Explicit IPv6 addresses do not take IPv4 connections so that they can
+    // be combined with IPv4 listeners on the same port.
+    if (c_simple_http_internal_listeners_add(listeners,
+                                             inherited,
+                                             (const struct sockaddr *)&addr,
+                                             addr_len,
+                                             reuse_port,
+                                             1,
+                                             args) != 0) {
+      c_simple_http_listeners_cleanup(listeners);
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+int c_simple_http_listeners_open_for_worker(
+    C_SIMPLE_HTTP_Listeners *listeners,
+    const C_SIMPLE_HTTP_Listeners *main,
+    C_SIMPLE_HTTP_InheritedListeners *inherited,
+    const Args *args) {
+  memset(listeners, 0, sizeof(C_SIMPLE_HTTP_Listeners));
+
+  for (uint32_t idx = 0; idx < main->count; ++idx) {
+    const C_SIMPLE_HTTP_Listener *main_listener = &main->listeners[idx];
+    if (main_listener->addr.ss_family == AF_UNIX) {
+      // Unix sockets do not support SO_REUSEPORT, so the workers accept from
+      // the same socket.
+      C_SIMPLE_HTTP_Listener *listener =
+        &listeners->listeners[listeners->count++];
+      *listener = *main_listener;
+      listener->flags &= ~(uint32_t)3;
+      continue;
+    }
+
+    int v6_only = 0;
+    socklen_t v6_only_size = sizeof(int);
+    if (main_listener->addr.ss_family == AF_INET6) {
+      getsockopt(main_listener->fd,
+                 IPPROTO_IPV6,
+                 IPV6_V6ONLY,
+                 &v6_only,
+                 &v6_only_size);
+    }
+    if (c_simple_http_internal_listeners_add(
+          listeners,
+          inherited,
+          (const struct sockaddr *)&main_listener->addr,
+          main_listener->addr_len,
+          1,
+          v6_only ? 1 : 0,
+          args) != 0) {
+      c_simple_http_listeners_cleanup(listeners);
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+void c_simple_http_listener_print(FILE *out,
+                                  const C_SIMPLE_HTTP_Listener *listener) {
+  char addr_buf[INET6_ADDRSTRLEN];
+  switch (listener->addr.ss_family) {
+    case AF_UNIX: {
+      const struct sockaddr_un *unix_addr =
+        (const struct sockaddr_un *)&listener->addr;
+      if (unix_addr->sun_path[0] != 0) {
+        fprintf(out, "unix:%s", unix_addr->sun_path);
+      } else {
+        const size_t name_len = listener->addr_len
+          - offsetof(struct sockaddr_un, sun_path) - 1;
+        fprintf(out, "unix:@%.*s", (int)name_len, unix_addr->sun_path + 1);
+      }
+      break;
+    }
+    case AF_INET: {
+      const struct sockaddr_in *ipv4_addr =
+        (const struct sockaddr_in *)&listener->addr;
+      inet_ntop(AF_INET, &ipv4_addr->sin_addr, addr_buf, sizeof(addr_buf));
+      fprintf(out, "%s:%u", addr_buf, u16_be_swap(ipv4_addr->sin_port));
+      break;
+    }
+    case AF_INET6: {
+      const struct sockaddr_in6 *ipv6_addr =
+        (const struct sockaddr_in6 *)&listener->addr;
+      inet_ntop(AF_INET6, &ipv6_addr->sin6_addr, addr_buf, sizeof(addr_buf));
+      fprintf(out, "[%s]:%u", addr_buf, u16_be_swap(ipv6_addr->sin6_port));
+      break;
+    }
+    default:
+      fprintf(out, "(unknown address family)");
+      break;
+  }
+}
+
+void c_simple_http_listener_peer_to_ipv6(const struct sockaddr_storage *peer,
+                                         struct in6_addr *addr_out) {
+  memset(addr_out, 0, sizeof(struct in6_addr));
+  if (peer->ss_family == AF_INET6) {
+    *addr_out = ((const struct sockaddr_in6 *)peer)->sin6_addr;
+  } else if (peer->ss_family == AF_INET) {
+    // IPv4-mapped, "::ffff:a.b.c.d".
+    addr_out->s6_addr[10] = 0xFF;
+    addr_out->s6_addr[11] = 0xFF;
+    memcpy(addr_out->s6_addr + 12,
+           &((const struct sockaddr_in *)peer)->sin_addr,
+           4);
+  }
+}
+
+void c_simple_http_listeners_cleanup(C_SIMPLE_HTTP_Listeners *listeners) {
+  if (listeners) {
+    for (uint32_t idx = 0; idx < listeners->count; ++idx) {
+      C_SIMPLE_HTTP_Listener *listener = &listeners->listeners[idx];
+      if ((listener->flags & 1) != 0 && listener->fd >= 0) {
+        close(listener->fd);
+      }
+      if ((listener->flags & 2) != 0) {
+        unlink(((const struct sockaddr_un *)&listener->addr)->sun_path);
+      }
+      listener->fd = -1;
+      listener->flags = 0;
+    }
+    listeners->count = 0;
+  }
+}
+
+int c_simple_http_listeners_inherit(
+    C_SIMPLE_HTTP_InheritedListeners *inherited) {
+  memset(inherited, 0, sizeof(C_SIMPLE_HTTP_InheritedListeners));
+
+  const char *pid_str = getenv("LISTEN_PID");
+  const char *fds_str = getenv("LISTEN_FDS");
+  if (!pid_str || !fds_str) {
+    return 0;
+  }
+  char *pid_end;
+  char *fds_end;
+  const unsigned long pid = strtoul(pid_str, &pid_end, 10);
+  const unsigned long fd_count = strtoul(fds_str, &fds_end, 10);
+  // Sockets meant for another process are not ours to take.
+  const int_fast8_t is_ours = pid_str[0] >= '0' && pid_str[0] <= '9'
+                              && *pid_end == 0
+                              && pid == (unsigned long)getpid();
+  const int_fast8_t is_valid = fds_str[0] >= '0' && fds_str[0] <= '9'
+                               && *fds_end == 0 && fd_count <= 0xFFFF;
+  if (is_ours && !is_valid) {
+    fprintf(stderr, "ERROR Invalid LISTEN_FDS=%s !\n", fds_str);
+  }
+  // Child processes (like xdg-mime) must not think that the sockets are
+  // theirs.
+  unsetenv("LISTEN_PID");
+  unsetenv("LISTEN_FDS");
+  unsetenv("LISTEN_FDNAMES");
+  if (!is_ours) {
+    return 0;
+  } else if (!is_valid) {
+    return 1;
+  } else if (fd_count == 0) {
+    return 0;
+  }
+
+  inherited->listeners = malloc(sizeof(C_SIMPLE_HTTP_Listener) * fd_count);
+  if (!inherited->listeners) {
+    fprintf(stderr, "ERROR Failed to allocate inherited listeners!\n");
+    return 1;
+  }
+
+  for (int fd = 3; fd < 3 + (int)fd_count; ++fd) {
+    C_SIMPLE_HTTP_Listener *listener =
+      &inherited->listeners[inherited->count];
+    memset(listener, 0, sizeof(C_SIMPLE_HTTP_Listener));
+    listener->fd = fd;
+    listener->addr_len = sizeof(struct sockaddr_storage);
+
+    int accepting = 0;
+    socklen_t accepting_size = sizeof(int);
+    if (getsockopt(fd,
+                   SOL_SOCKET,
+                   SO_ACCEPTCONN,
+                   &accepting,
+                   &accepting_size) != 0
+        || !accepting
+        || getsockname(fd,
+                       (struct sockaddr *)&listener->addr,
+                       &listener->addr_len) != 0) {
+      fprintf(stderr,
+              "WARNING Inherited fd %d is not a listening socket, "
+              "closing...\n",
+              fd);
+      close(fd);
+      continue;
+    }
+
+    int fd_flags = fcntl(fd, F_GETFD);
+    int fl_flags = fcntl(fd, F_GETFL);
+    if (fd_flags < 0 || fl_flags < 0
+        || fcntl(fd, F_SETFD, fd_flags | FD_CLOEXEC) != 0
+        || fcntl(fd, F_SETFL, fl_flags | O_NONBLOCK) != 0) {
+      fprintf(stderr,
+              "ERROR Failed to set up inherited socket! (errno %d)\n",
+              errno);
+      c_simple_http_inherited_listeners_cleanup(inherited);
+      return 1;
+    }
+
+    listener->flags = 1;
+    if (listener->addr.ss_family == AF_UNIX
+        && ((const struct sockaddr_un *)&listener->addr)->sun_path[0] != 0) {
+      listener->flags |= 2;
+    }
+    ++inherited->count;
+  }
+
+  return 0;
+}
+
+void c_simple_http_listeners_adopt(
+    C_SIMPLE_HTTP_Listeners *listeners,
+    C_SIMPLE_HTTP_InheritedListeners *inherited) {
+  while (inherited->count > 0
+      && listeners->count < C_SIMPLE_HTTP_LISTENERS_MAX) {
+    listeners->listeners[listeners->count++] =
+      inherited->listeners[--inherited->count];
+  }
+  if (inherited->count > 0) {
+    fprintf(stderr,
+            "WARNING Too many inherited listening sockets, closing %" PRIu32
+            " of them...\n",
+            inherited->count);
+  }
+}
+
+void c_simple_http_inherited_listeners_cleanup(
+    C_SIMPLE_HTTP_InheritedListeners *inherited) {
+  if (inherited && inherited->listeners) {
+    for (uint32_t idx = 0; idx < inherited->count; ++idx) {
+      // The socket files are still used by the listeners in the previous
+      // process.
+      close(inherited->listeners[idx].fd);
+    }
+    free(inherited->listeners);
+    inherited->listeners = NULL;
+    inherited->count = 0;
+  }
+}
+
+// vim: et ts=2 sts=2 sw=2
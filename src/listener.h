@@ -0,0 +1,131 @@
+// ISC License
+// 
+// Copyright (c) 2024-2025 Stephen Seo
+// 
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef SEODISPARATE_COM_C_SIMPLE_HTTP_LISTENER_H_
+#define SEODISPARATE_COM_C_SIMPLE_HTTP_LISTENER_H_
+
+// Standard library includes.
+#include <stdint.h>
+#include <stdio.h>
+
+// Linux/Unix includes.
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+// Local includes.
+#include "arg_parse.h"
+
+#define C_SIMPLE_HTTP_LISTENERS_MAX 16
+
+typedef struct C_SIMPLE_HTTP_Listener {
+  int fd;
+  // xxxx xxx1 - fd is owned and closed on cleanup.
+  // xxxx xx1x - is a unix socket file that is unlinked on cleanup.
+  // xxxx x1xx - connections may be pending, set by the epoll loop on events
+  //             and when the accept budget ran out.
+  // xxxx 1xxx - an io_uring accept is submitted on the listener.
+  uint32_t flags;
+  socklen_t addr_len;
+  // The bound address, with the actual port if port 0 was requested.
+  struct sockaddr_storage addr;
+} C_SIMPLE_HTTP_Listener;
+
+typedef struct C_SIMPLE_HTTP_Listeners {
+  C_SIMPLE_HTTP_Listener listeners[C_SIMPLE_HTTP_LISTENERS_MAX];
+  uint32_t count;
+} C_SIMPLE_HTTP_Listeners;
+
+/// Listening sockets passed on from a previous process (or systemd).
+typedef struct C_SIMPLE_HTTP_InheritedListeners {
+  C_SIMPLE_HTTP_Listener *listeners;
+  uint32_t count;
+} C_SIMPLE_HTTP_InheritedListeners;
+
+/// Parses a "--listen" address into "addr_out". Accepted forms are
+/// "unix:<path>" (a leading '@' in the path is the abstract namespace),
+/// "<IPv4>[:<port>]", and "[<IPv6>][:<port>]". "default_port" is used if the
+/// port is omitted.
+/// Returns zero on success.
+int c_simple_http_listener_parse_addr(const char *str,
+                                      uint16_t default_port,
+                                      struct sockaddr_storage *addr_out,
+                                      socklen_t *addr_len_out);
+
+/// Creates a listening socket bound to "addr". If "reuse_port" is non-zero,
+/// SO_REUSEPORT is set so that multiple sockets (one per worker) may listen
+/// on the same TCP port. The backlog and the other listener options are taken
+/// from "args". If "v6_only" is non-zero, IPv6 sockets do not accept IPv4
+/// connections. Stale unix socket files are removed before binding.
+/// Returns the socket fd, or -1 on error.
+int c_simple_http_listener_create(const struct sockaddr *addr,
+                                  socklen_t addr_len,
+                                  int_fast8_t reuse_port,
+                                  int_fast8_t v6_only,
+                                  const Args *args);
+
+/// Takes the listening sockets passed with the "LISTEN_FDS" and "LISTEN_PID"
+/// environment variables (as with systemd socket activation), starting at fd
+/// 3. The variables are removed from the environment. Inherited fds that are
+/// not listening sockets are closed.
+/// Returns zero on success, including when there are none.
+int c_simple_http_listeners_inherit(C_SIMPLE_HTTP_InheritedListeners *inherited);
+
+/// Opens a listener for every "--listen" address in "args", or a dual-stack
+/// IPv6 listener on "--port" if there are none. Inherited sockets bound to a
+/// matching address are used instead of new ones, and are removed from
+/// "inherited" (which may be NULL).
+/// Returns zero on success.
+int c_simple_http_listeners_open(C_SIMPLE_HTTP_Listeners *listeners,
+                                 C_SIMPLE_HTTP_InheritedListeners *inherited,
+                                 const Args *args);
+
+/// Opens a worker's listeners for the addresses already bound by "main".
+/// TCP listeners get their own SO_REUSEPORT socket so that the kernel spreads
+/// connections between the workers, unix sockets are shared. Matching
+/// inherited sockets are used first, as with c_simple_http_listeners_open().
+/// Returns zero on success.
+int c_simple_http_listeners_open_for_worker(
+  C_SIMPLE_HTTP_Listeners *listeners,
+  const C_SIMPLE_HTTP_Listeners *main,
+  C_SIMPLE_HTTP_InheritedListeners *inherited,
+  const Args *args);
+
+/// Moves the inherited sockets that were not used by the listeners (for
+/// example if there are now fewer workers) to "listeners" so that their
+/// pending connections are still accepted. The sockets that do not fit are
+/// closed.
+void c_simple_http_listeners_adopt(C_SIMPLE_HTTP_Listeners *listeners,
+                                   C_SIMPLE_HTTP_InheritedListeners *inherited);
+
+/// Prints the address of a listener to "out".
+void c_simple_http_listener_print(FILE *out,
+                                  const C_SIMPLE_HTTP_Listener *listener);
+
+/// Stores the IP address of an accepted peer in "addr_out". IPv4 addresses
+/// are IPv4-mapped, and unix socket peers have the unspecified address.
+void c_simple_http_listener_peer_to_ipv6(const struct sockaddr_storage *peer,
+                                         struct in6_addr *addr_out);
+
+/// Closes the owned listener fds and removes the owned unix socket files.
+void c_simple_http_listeners_cleanup(C_SIMPLE_HTTP_Listeners *listeners);
+
+/// Closes the remaining inherited sockets and frees "inherited".
+void c_simple_http_inherited_listeners_cleanup(
+  C_SIMPLE_HTTP_InheritedListeners *inherited);
+
+#endif
+
+// vim: et ts=2 sts=2 sw=2
@@ -0,0 +1,199 @@
+// ISC License
+// 
+// Copyright (c) 2026 Stephen Seo
+// 
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "output_queue.h"
+
+// Standard library includes.
+#include <stdlib.h>
+#include <string.h>
+
+/// Counts "size" more unsent bytes.
+void c_simple_http_internal_output_queue_grow(C_SIMPLE_HTTP_OutputQueue *queue,
+                                              size_t size) {
+  queue->size += size;
+  if (queue->total) {
+    *queue->total += size;
+  }
+}
+
+/// Returns a new zeroed chunk at the end of the queue, or NULL on failure.
+C_SIMPLE_HTTP_OutputChunk *c_simple_http_internal_output_queue_push(
+    C_SIMPLE_HTTP_OutputQueue *queue) {
+  if (queue->count == queue->capacity) {
+    if (queue->head != 0) {
+      // Reuse the space of sent chunks.
+      memmove(queue->chunks,
+              queue->chunks + queue->head,
+              (queue->count - queue->head) * sizeof(C_SIMPLE_HTTP_OutputChunk));
+      queue->count -= queue->head;
+      queue->head = 0;
+    } else {
+      size_t new_capacity = queue->capacity == 0 ? 8 : queue->capacity * 2;
+      C_SIMPLE_HTTP_OutputChunk *new_chunks = realloc(
+        queue->chunks, new_capacity * sizeof(C_SIMPLE_HTTP_OutputChunk));
+      if (!new_chunks) {
+        return NULL;
+      }
+      queue->chunks = new_chunks;
+      queue->capacity = new_capacity;
+    }
+  }
+
+  C_SIMPLE_HTTP_OutputChunk *chunk = &queue->chunks[queue->count++];
+  memset(chunk, 0, sizeof(C_SIMPLE_HTTP_OutputChunk));
+  return chunk;
+}
+
+int c_simple_http_output_queue_add_ref(C_SIMPLE_HTTP_OutputQueue *queue,
+                                       const void *data,
+                                       size_t size) {
+  if (size == 0) {
+    return 0;
+  }
+  C_SIMPLE_HTTP_OutputChunk *chunk =
+    c_simple_http_internal_output_queue_push(queue);
+  if (!chunk) {
+    return 1;
+  }
+  chunk->data = data;
+  chunk->size = size;
+  c_simple_http_internal_output_queue_grow(queue, size);
+  return 0;
+}
+
+int c_simple_http_output_queue_add_owned(C_SIMPLE_HTTP_OutputQueue *queue,
+                                         void *data,
+                                         size_t size) {
+  if (size == 0) {
+    free(data);
+    return 0;
+  }
+  C_SIMPLE_HTTP_OutputChunk *chunk =
+    c_simple_http_internal_output_queue_push(queue);
+  if (!chunk) {
+    free(data);
+    return 1;
+  }
+  chunk->data = data;
+  chunk->size = size;
+  chunk->owned = data;
+  c_simple_http_internal_output_queue_grow(queue, size);
+  return 0;
+}
+
+int c_simple_http_output_queue_add_copy(C_SIMPLE_HTTP_OutputQueue *queue,
+                                        const void *data,
+                                        size_t size) {
+  if (size > C_SIMPLE_HTTP_OUTPUT_INLINE_SIZE) {
+    void *copy = malloc(size);
+    if (!copy) {
+      return 1;
+    }
+    memcpy(copy, data, size);
+    return c_simple_http_output_queue_add_owned(queue, copy, size);
+  } else if (size == 0) {
+    return 0;
+  }
+
+  C_SIMPLE_HTTP_OutputChunk *chunk =
+    c_simple_http_internal_output_queue_push(queue);
+  if (!chunk) {
+    return 1;
+  }
+  memcpy(chunk->inline_data, data, size);
+  chunk->size = size;
+  c_simple_http_internal_output_queue_grow(queue, size);
+  return 0;
+}
+
+int c_simple_http_output_queue_to_iovecs(const C_SIMPLE_HTTP_OutputQueue *queue,
+                                         struct iovec *iovecs,
+                                         int max) {
+  int iovec_count = 0;
+  for (size_t idx = queue->head;
+      idx < queue->count && iovec_count < max;
+      ++idx) {
+    const C_SIMPLE_HTTP_OutputChunk *chunk = &queue->chunks[idx];
+    const char *data = chunk->data ? chunk->data : chunk->inline_data;
+    iovecs[iovec_count].iov_base = (void *)(data + chunk->offset);
+    iovecs[iovec_count].iov_len = chunk->size - chunk->offset;
+    ++iovec_count;
+  }
+  return iovec_count;
+}
+
+struct msghdr *c_simple_http_output_queue_to_msg(
+    C_SIMPLE_HTTP_OutputQueue *queue) {
+  if (!queue->msg) {
+    queue->msg = malloc(sizeof(C_SIMPLE_HTTP_OutputMsg));
+    if (!queue->msg) {
+      return NULL;
+    }
+  }
+  memset(&queue->msg->msg, 0, sizeof(struct msghdr));
+  queue->msg->msg.msg_iov = queue->msg->iovecs;
+  queue->msg->msg.msg_iovlen = (size_t)c_simple_http_output_queue_to_iovecs(
+    queue, queue->msg->iovecs, C_SIMPLE_HTTP_OUTPUT_MAX_IOVECS);
+  return &queue->msg->msg;
+}
+
+void c_simple_http_output_queue_consume(C_SIMPLE_HTTP_OutputQueue *queue,
+                                        size_t sent) {
+  queue->size -= sent;
+  if (queue->total) {
+    *queue->total -= sent;
+  }
+  while (sent > 0 && queue->head < queue->count) {
+    C_SIMPLE_HTTP_OutputChunk *chunk = &queue->chunks[queue->head];
+    size_t remaining = chunk->size - chunk->offset;
+    if (sent < remaining) {
+      chunk->offset += sent;
+      return;
+    }
+    sent -= remaining;
+    free(chunk->owned);
+    chunk->owned = NULL;
+    ++queue->head;
+  }
+
+  if (queue->head == queue->count) {
+    queue->head = 0;
+    queue->count = 0;
+  }
+}
+
+void c_simple_http_output_queue_clear(C_SIMPLE_HTTP_OutputQueue *queue) {
+  for (size_t idx = queue->head; idx < queue->count; ++idx) {
+    free(queue->chunks[idx].owned);
+  }
+  queue->head = 0;
+  queue->count = 0;
+  if (queue->total) {
+    *queue->total -= queue->size;
+  }
+  queue->size = 0;
+}
+
+void c_simple_http_output_queue_cleanup(C_SIMPLE_HTTP_OutputQueue *queue) {
+  c_simple_http_output_queue_clear(queue);
+  free(queue->chunks);
+  queue->chunks = NULL;
+  queue->capacity = 0;
+  free(queue->msg);
+  queue->msg = NULL;
+}
+
+// vim: et ts=2 sts=2 sw=2
@@ -0,0 +1,110 @@
+// ISC License
+// 
+// Copyright (c) 2026 Stephen Seo
+// 
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef SEODISPARATE_COM_C_SIMPLE_HTTP_OUTPUT_QUEUE_H_
+#define SEODISPARATE_COM_C_SIMPLE_HTTP_OUTPUT_QUEUE_H_
+
+// Standard library includes.
+#include <stddef.h>
+
+// Linux/Unix includes.
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+// Small chunks are copied into the chunk itself.
+#define C_SIMPLE_HTTP_OUTPUT_INLINE_SIZE 32
+// Max number of iovecs passed to a single writev/sendmsg.
+#define C_SIMPLE_HTTP_OUTPUT_MAX_IOVECS 32
+
+typedef struct C_SIMPLE_HTTP_OutputChunk {
+  // Is NULL if the data is in "inline_data".
+  const char *data;
+  size_t size;
+  // Number of bytes already sent.
+  size_t offset;
+  // Free'd once the chunk is sent, may be NULL.
+  void *owned;
+  char inline_data[C_SIMPLE_HTTP_OUTPUT_INLINE_SIZE];
+} C_SIMPLE_HTTP_OutputChunk;
+
+/// Message for sends that complete asynchronously (io_uring), which must stay
+/// valid until the send completes.
+typedef struct C_SIMPLE_HTTP_OutputMsg {
+  struct msghdr msg;
+  struct iovec iovecs[C_SIMPLE_HTTP_OUTPUT_MAX_IOVECS];
+} C_SIMPLE_HTTP_OutputMsg;
+
+/// Queue of data to send, which is sent with writev/sendmsg without first
+/// copying it into a single buffer.
+typedef struct C_SIMPLE_HTTP_OutputQueue {
+  C_SIMPLE_HTTP_OutputChunk *chunks;
+  size_t capacity;
+  // Index of the first chunk with unsent data.
+  size_t head;
+  size_t count;
+  // Total number of unsent bytes.
+  size_t size;
+  // If not NULL, the unsent bytes are also counted here, which may be shared
+  // by multiple queues.
+  size_t *total;
+  // Allocated on first use by c_simple_http_output_queue_to_msg().
+  C_SIMPLE_HTTP_OutputMsg *msg;
+} C_SIMPLE_HTTP_OutputQueue;
+
+/// Queues "data" without copying it. "data" must stay valid until it is sent,
+/// so this should be used for constant data.
+/// Returns zero on success.
+int c_simple_http_output_queue_add_ref(C_SIMPLE_HTTP_OutputQueue *queue,
+                                       const void *data,
+                                       size_t size);
+
+/// Queues "data" without copying it, and frees it after it is sent. "data" is
+/// free'd even on failure.
+/// Returns zero on success.
+int c_simple_http_output_queue_add_owned(C_SIMPLE_HTTP_OutputQueue *queue,
+                                         void *data,
+                                         size_t size);
+
+/// Queues a copy of "data".
+/// Returns zero on success.
+int c_simple_http_output_queue_add_copy(C_SIMPLE_HTTP_OutputQueue *queue,
+                                        const void *data,
+                                        size_t size);
+
+/// Fills "iovecs" with up to "max" of the unsent chunks.
+/// Returns the number of iovecs filled.
+int c_simple_http_output_queue_to_iovecs(const C_SIMPLE_HTTP_OutputQueue *queue,
+                                         struct iovec *iovecs,
+                                         int max);
+
+/// Fills "queue->msg" (allocated on first use) with the unsent chunks. Chunks
+/// must not be added to the queue until the send with it completes.
+/// Returns NULL on failure.
+struct msghdr *c_simple_http_output_queue_to_msg(
+  C_SIMPLE_HTTP_OutputQueue *queue);
+
+/// Marks "sent" bytes as sent, freeing the chunks that were fully sent.
+void c_simple_http_output_queue_consume(C_SIMPLE_HTTP_OutputQueue *queue,
+                                        size_t sent);
+
+/// Removes all chunks.
+void c_simple_http_output_queue_clear(C_SIMPLE_HTTP_OutputQueue *queue);
+
+void c_simple_http_output_queue_cleanup(C_SIMPLE_HTTP_OutputQueue *queue);
+
+#endif
+
+// vim: et ts=2 sts=2 sw=2
@@ -0,0 +1,144 @@
+// ISC License
+// 
+// Copyright (c) 2026 Stephen Seo
+// 
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "rate_limit.h"
+
+// Standard library includes.
+#include <stdlib.h>
+#include <string.h>
+
+// Linux/Unix includes.
+#include <sys/random.h>
+
+// Local includes.
+#include "constants.h"
+
+/// Sets "key_out" to the bucket key of "addr".
+void c_simple_http_internal_rate_limit_key(const struct in6_addr *addr,
+                                           uint64_t key_out[2]) {
+  memcpy(key_out, addr->s6_addr, 16);
+  if (!IN6_IS_ADDR_V4MAPPED(addr)) {
+    // An IPv6 client usually has a whole /64.
+    key_out[1] = 0;
+  }
+}
+
+uint64_t c_simple_http_internal_rate_limit_hash(
+    const C_SIMPLE_HTTP_RateLimiter *limiter,
+    const uint64_t key[2]) {
+  uint64_t hash = limiter->seed ^ key[0];
+  hash = (hash ^ (hash >> 33)) * 0xFF51AFD7ED558CCDULL;
+  hash ^= key[1];
+  hash = (hash ^ (hash >> 33)) * 0xC4CEB9FE1A85EC53ULL;
+  return hash ^ (hash >> 33);
+}
+
+int c_simple_http_rate_limiter_init(C_SIMPLE_HTTP_RateLimiter *limiter,
+                                    uint32_t rate,
+                                    uint32_t burst) {
+  memset(limiter, 0, sizeof(C_SIMPLE_HTTP_RateLimiter));
+  limiter->buckets = calloc(C_SIMPLE_HTTP_RATE_LIMIT_TABLE_SIZE,
+                            sizeof(C_SIMPLE_HTTP_RateLimitBucket));
+  if (!limiter->buckets) {
+    return 1;
+  }
+  limiter->rate = rate;
+  limiter->burst = burst;
+  if (getrandom(&limiter->seed, sizeof(uint64_t), GRND_NONBLOCK)
+      != (ssize_t)sizeof(uint64_t)) {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    limiter->seed = (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec;
+  }
+  if (pthread_mutex_init(&limiter->mutex, NULL) != 0) {
+    free(limiter->buckets);
+    limiter->buckets = NULL;
+    return 1;
+  }
+  return 0;
+}
+
+void c_simple_http_rate_limiter_cleanup(C_SIMPLE_HTTP_RateLimiter *limiter) {
+  if (limiter && limiter->buckets) {
+    free(limiter->buckets);
+    limiter->buckets = NULL;
+    pthread_mutex_destroy(&limiter->mutex);
+  }
+}
+
+int c_simple_http_rate_limiter_take(C_SIMPLE_HTTP_RateLimiter *limiter,
+                                    const struct in6_addr *addr,
+                                    const struct timespec *now) {
+  if (IN6_IS_ADDR_UNSPECIFIED(addr)) {
+    return 0;
+  }
+
+  uint64_t key[2];
+  c_simple_http_internal_rate_limit_key(addr, key);
+  const uint64_t hash = c_simple_http_internal_rate_limit_hash(limiter, key);
+  const int64_t now_millis =
+    (int64_t)now->tv_sec * 1000 + now->tv_nsec / 1000000;
+  const uint64_t max_tokens = (uint64_t)limiter->burst * 1000;
+
+  pthread_mutex_lock(&limiter->mutex);
+  C_SIMPLE_HTTP_RateLimitBucket *bucket = NULL;
+  C_SIMPLE_HTTP_RateLimitBucket *oldest = NULL;
+  for (uint32_t probe = 0; probe < C_SIMPLE_HTTP_RATE_LIMIT_PROBES; ++probe) {
+    C_SIMPLE_HTTP_RateLimitBucket *entry = &limiter->buckets[
+      (hash + probe) & (C_SIMPLE_HTTP_RATE_LIMIT_TABLE_SIZE - 1)];
+    if ((entry->flags & 1) == 0) {
+      if (!oldest || (oldest->flags & 1) != 0) {
+        oldest = entry;
+      }
+    } else if (entry->key[0] == key[0] && entry->key[1] == key[1]) {
+      bucket = entry;
+      break;
+    } else if (!oldest
+        || ((oldest->flags & 1) != 0
+          && entry->time_millis < oldest->time_millis)) {
+      oldest = entry;
+    }
+  }
+
+  if (bucket) {
+    const int64_t elapsed = now_millis - bucket->time_millis;
+    if (elapsed > 0) {
+      // "rate" per second is "rate" thousandths per millisecond.
+      uint64_t tokens =
+        bucket->tokens + (uint64_t)elapsed * limiter->rate;
+      bucket->tokens = (uint32_t)(tokens > max_tokens ? max_tokens : tokens);
+      bucket->time_millis = now_millis;
+    }
+  } else {
+    // A new (or evicted) client starts with a full bucket.
+    bucket = oldest;
+    bucket->key[0] = key[0];
+    bucket->key[1] = key[1];
+    bucket->tokens = (uint32_t)max_tokens;
+    bucket->time_millis = now_millis;
+    bucket->flags = 1;
+  }
+
+  int ret = 1;
+  if (bucket->tokens >= 1000) {
+    bucket->tokens -= 1000;
+    ret = 0;
+  }
+  pthread_mutex_unlock(&limiter->mutex);
+  return ret;
+}
+
+// vim: et ts=2 sts=2 sw=2
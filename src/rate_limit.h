@@ -0,0 +1,71 @@
+// ISC License
+// 
+// Copyright (c) 2026 Stephen Seo
+// 
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef SEODISPARATE_COM_C_SIMPLE_HTTP_RATE_LIMIT_H_
+#define SEODISPARATE_COM_C_SIMPLE_HTTP_RATE_LIMIT_H_
+
+// Standard library includes.
+#include <stdint.h>
+
+// Linux/Unix includes.
+#include <netinet/in.h>
+#include <pthread.h>
+#include <time.h>
+
+typedef struct C_SIMPLE_HTTP_RateLimitBucket {
+  // The client's IPv4 address (IPv4-mapped), or the /64 prefix of its IPv6
+  // address.
+  uint64_t key[2];
+  // CLOCK_MONOTONIC milliseconds of the last update of "tokens".
+  int64_t time_millis;
+  // In thousandths of a request.
+  uint32_t tokens;
+  // xxxx xxx1 - in use.
+  uint32_t flags;
+} C_SIMPLE_HTTP_RateLimitBucket;
+
+/// Fixed-size, open-addressed table of token buckets, shared by all workers.
+/// A client that is not found within C_SIMPLE_HTTP_RATE_LIMIT_PROBES slots
+/// takes over the least recently used of them.
+typedef struct C_SIMPLE_HTTP_RateLimiter {
+  C_SIMPLE_HTTP_RateLimitBucket *buckets;
+  // Tokens (requests) added per second.
+  uint32_t rate;
+  // Max tokens of a bucket.
+  uint32_t burst;
+  // Randomizes the slots clients are hashed to.
+  uint64_t seed;
+  pthread_mutex_t mutex;
+} C_SIMPLE_HTTP_RateLimiter;
+
+/// Allocates C_SIMPLE_HTTP_RATE_LIMIT_TABLE_SIZE buckets.
+/// Returns zero on success.
+int c_simple_http_rate_limiter_init(C_SIMPLE_HTTP_RateLimiter *limiter,
+                                    uint32_t rate,
+                                    uint32_t burst);
+
+void c_simple_http_rate_limiter_cleanup(C_SIMPLE_HTTP_RateLimiter *limiter);
+
+/// Takes a token from the bucket of "addr" (a full bucket for a new client).
+/// Unspecified addresses ("::", for unix socket peers) are not limited.
+/// Returns zero if allowed, non-zero if the client is over the limit.
+int c_simple_http_rate_limiter_take(C_SIMPLE_HTTP_RateLimiter *limiter,
+                                    const struct in6_addr *addr,
+                                    const struct timespec *now);
+
+#endif
+
+// vim: et ts=2 sts=2 sw=2
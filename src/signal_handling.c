@@ -18,19 +18,43 @@
 
 // Standard library includes.
 #include <stdio.h>
+#include <stdint.h>
 
 // Unix includes.
 #include <signal.h>
+#include <unistd.h>
+#include <errno.h>
 
 // Local includes
 #include "globals.h"
 
+void C_SIMPLE_HTTP_signal_wakeup(void) {
+  if (C_SIMPLE_HTTP_WAKEUP_FD >= 0) {
+    // Preserve errno as this is called from signal handlers.
+    int prev_errno = errno;
+    uint64_t value = 1;
+    ssize_t ret = write(C_SIMPLE_HTTP_WAKEUP_FD, &value, sizeof(uint64_t));
+    (void)ret;
+    errno = prev_errno;
+  }
+}
+
+void C_SIMPLE_HTTP_begin_shutdown(void) {
+  if (C_SIMPLE_HTTP_DRAINING) {
+    // A second signal stops without waiting for the connections.
+    C_SIMPLE_HTTP_KEEP_RUNNING = 0;
+  } else {
+    C_SIMPLE_HTTP_DRAINING = 1;
+  }
+  C_SIMPLE_HTTP_signal_wakeup();
+}
+
 void C_SIMPLE_HTTP_handle_sigint(int signal) {
   if (signal == SIGINT) {
 #ifndef NDEBUG
     puts("Handling SIGINT");
 #endif
-    C_SIMPLE_HTTP_KEEP_RUNNING = 0;
+    C_SIMPLE_HTTP_begin_shutdown();
   }
 }
 
@@ -40,6 +64,7 @@ void C_SIMPLE_HTTP_handle_sighup(int signal) {
     puts("Handling SIGHUP");
 #endif
     C_SIMPLE_HTTP_KEEP_RUNNING = 0;
+    C_SIMPLE_HTTP_signal_wakeup();
   }
 }
 
@@ -48,7 +73,7 @@ void C_SIMPLE_HTTP_handle_sigterm(int signal) {
 #ifndef NDEBUG
     puts("Handling SIGTERM");
 #endif
-    C_SIMPLE_HTTP_KEEP_RUNNING = 0;
+    C_SIMPLE_HTTP_begin_shutdown();
   }
 }
 
@@ -58,6 +83,17 @@ void C_SIMPLE_HTTP_handle_sigusr1(int signal) {
     puts("Handling SIGUSR1");
 #endif
     C_SIMPLE_HTTP_SIGUSR1_SET = 1;
+    C_SIMPLE_HTTP_signal_wakeup();
+  }
+}
+
+void C_SIMPLE_HTTP_handle_sigusr2(int signal) {
+  if (signal == SIGUSR2) {
+#ifndef NDEBUG
+    puts("Handling SIGUSR2");
+#endif
+    C_SIMPLE_HTTP_SIGUSR2_SET = 1;
+    C_SIMPLE_HTTP_signal_wakeup();
   }
 }
 
@@ -17,10 +17,19 @@
 #ifndef SEODISPARATE_COM_C_SIMPLE_HTTP_SIGNAL_HANDLING_H_
 #define SEODISPARATE_COM_C_SIMPLE_HTTP_SIGNAL_HANDLING_H_
 
+/// Writes to C_SIMPLE_HTTP_WAKEUP_FD (if valid) to wake up the event loop.
+/// Is async-signal-safe.
+void C_SIMPLE_HTTP_signal_wakeup(void);
+
+/// Starts draining the event loops, or stops them right away if they are
+/// already draining. Is async-signal-safe.
+void C_SIMPLE_HTTP_begin_shutdown(void);
+
 void C_SIMPLE_HTTP_handle_sigint(int signal);
 void C_SIMPLE_HTTP_handle_sighup(int signal);
 void C_SIMPLE_HTTP_handle_sigterm(int signal);
 void C_SIMPLE_HTTP_handle_sigusr1(int signal);
+void C_SIMPLE_HTTP_handle_sigusr2(int signal);
 void C_SIMPLE_HTTP_handle_sigpipe(int signal);
 
 int C_SIMPLE_HTTP_set_handle_signal(int signal, void (*handler)(int));
@@ -41,8 +41,9 @@
 
 // Local includes.
 #include "helpers.h"
+#include "http.h"
 
-char **environ;
+extern char **environ;
 
 void internal_fd_cleanup_helper(int *fd) {
   if (fd && *fd >= 0) {
@@ -59,17 +60,6 @@ void internal_cleanup_file_actions(posix_spawn_file_actions_t **actions) {
   }
 }
 
-void internal_cleanup_prev_cwd(char **path) {
-  if (path && *path) {
-    int ret = chdir(*path);
-    if (ret != 0) {
-      fprintf(stderr, "WARNING chdir back to cwd failed! (errno %d)\n", errno);
-    }
-    free(*path);
-    *path = NULL;
-  }
-}
-
 int_fast8_t c_simple_http_is_xdg_mime_available(void) {
   __attribute__((cleanup(internal_fd_cleanup_helper)))
   int dev_null_fd = open("/dev/null", O_WRONLY);
@@ -117,7 +107,10 @@ void c_simple_http_cleanup_static_file_info(
 }
 
 C_SIMPLE_HTTP_StaticFileInfo c_simple_http_get_file(
-    const char *static_dir, const char *path, int_fast8_t ignore_mime_type) {
+    const char *static_dir,
+    const char *path,
+    int_fast8_t ignore_mime_type,
+    int_fast8_t size_only) {
   C_SIMPLE_HTTP_StaticFileInfo file_info;
   memset(&file_info, 0, sizeof(C_SIMPLE_HTTP_StaticFileInfo));
 
@@ -127,47 +120,11 @@ C_SIMPLE_HTTP_StaticFileInfo c_simple_http_get_file(
   } else if (!ignore_mime_type && !c_simple_http_is_xdg_mime_available()) {
     file_info.result = STATIC_FILE_RESULT_NoXDGMimeAvailable;
     return file_info;
-  } else if (c_simple_http_static_validate_path(path) != 0) {
+  } else if (c_simple_http_path_has_dot_dot(path)) {
     file_info.result = STATIC_FILE_RESULT_InvalidPath;
     return file_info;
   }
 
-  uint64_t buf_size = 128;
-  char *buf = malloc(buf_size);
-  char *ptr;
-  while (1) {
-    ptr = getcwd(buf, buf_size);
-    if (ptr == NULL) {
-      if (errno == ERANGE) {
-        buf_size *= 2;
-        buf = realloc(buf, buf_size);
-        if (buf == NULL) {
-          file_info.result = STATIC_FILE_RESULT_InternalError;
-          return file_info;
-        }
-      } else {
-        free(buf);
-        file_info.result = STATIC_FILE_RESULT_InternalError;
-        return file_info;
-      }
-    } else {
-      break;
-    }
-  }
-
-  __attribute__((cleanup(internal_cleanup_prev_cwd)))
-  char *prev_cwd = buf;
-
-  int ret = chdir(static_dir);
-  if (ret != 0) {
-    fprintf(stderr,
-            "ERROR Failed to chdir into \"%s\"! (errno %d)\n",
-            static_dir,
-            errno);
-    file_info.result = STATIC_FILE_RESULT_InternalError;
-    return file_info;
-  }
-
   __attribute__((cleanup(simple_archiver_helper_cleanup_FILE)))
   FILE *fd = NULL;
   uint64_t idx = 0;
@@ -183,7 +140,28 @@ C_SIMPLE_HTTP_StaticFileInfo c_simple_http_get_file(
       return file_info;
     }
   }
-  fd = fopen(path + idx, "rb");
+
+  // The path is combined with "static_dir" instead of changing the working
+  // directory, as the cwd is shared between all worker threads.
+  __attribute__((cleanup(simple_archiver_helper_cleanup_c_string)))
+  char *full_path = NULL;
+  {
+    __attribute__((cleanup(simple_archiver_list_free)))
+    SDArchiverLinkedList *string_parts = simple_archiver_list_init();
+    const size_t static_dir_len = strlen(static_dir);
+    c_simple_http_add_string_part(string_parts, static_dir, 0);
+    if (static_dir_len > 0 && static_dir[static_dir_len - 1] != '/') {
+      c_simple_http_add_string_part(string_parts, "/", 0);
+    }
+    c_simple_http_add_string_part(string_parts, path + idx, 0);
+    full_path = c_simple_http_combine_string_parts(string_parts);
+  }
+  if (!full_path) {
+    file_info.result = STATIC_FILE_RESULT_InternalError;
+    return file_info;
+  }
+
+  fd = fopen(full_path, "rb");
 
   if (fd == NULL) {
     fprintf(
@@ -194,25 +172,31 @@ C_SIMPLE_HTTP_StaticFileInfo c_simple_http_get_file(
     return file_info;
   }
 
-  fseek(fd, 0, SEEK_END);
-  long long_ret = ftell(fd);
-  if (long_ret < 0) {
-    fprintf(stderr, "ERROR Failed to seek in path fd \"%s\"!\n", path);
+  // Directories can be opened too, but are not served. The size is taken
+  // from the metadata so that it is the same with "size_only".
+  struct stat file_stat;
+  if (fstat(fileno(fd), &file_stat) != 0) {
+    fprintf(stderr, "ERROR Failed to stat path fd \"%s\"!\n", path);
     file_info.result = STATIC_FILE_RESULT_FileError;
     return file_info;
-  }
-  fseek(fd, 0, SEEK_SET);
-  file_info.buf_size = (uint64_t)long_ret;
-  file_info.buf = malloc(file_info.buf_size);
-  size_t size_t_ret = fread(file_info.buf, 1, file_info.buf_size, fd);
-  if (size_t_ret != file_info.buf_size) {
-    fprintf(stderr, "ERROR Failed to read path fd \"%s\"!\n", path);
-    free(file_info.buf);
-    file_info.buf = NULL;
-    file_info.buf_size = 0;
+  } else if (!S_ISREG(file_stat.st_mode)) {
+    fprintf(stderr, "WARNING Path \"%s\" is not a regular file!\n", path);
     file_info.result = STATIC_FILE_RESULT_FileError;
     return file_info;
   }
+  file_info.buf_size = (uint64_t)file_stat.st_size;
+  if (!size_only) {
+    file_info.buf = malloc(file_info.buf_size);
+    size_t size_t_ret = fread(file_info.buf, 1, file_info.buf_size, fd);
+    if (size_t_ret != file_info.buf_size) {
+      fprintf(stderr, "ERROR Failed to read path fd \"%s\"!\n", path);
+      free(file_info.buf);
+      file_info.buf = NULL;
+      file_info.buf_size = 0;
+      file_info.result = STATIC_FILE_RESULT_FileError;
+      return file_info;
+    }
+  }
 
   simple_archiver_helper_cleanup_FILE(&fd);
 
@@ -220,7 +204,7 @@ C_SIMPLE_HTTP_StaticFileInfo c_simple_http_get_file(
     file_info.mime_type = strdup("application/octet-stream");
   } else {
     int from_xdg_mime_pipe[2];
-    ret = pipe(from_xdg_mime_pipe);
+    int ret = pipe(from_xdg_mime_pipe);
 
     __attribute__((cleanup(internal_cleanup_file_actions)))
     posix_spawn_file_actions_t *actions =
@@ -243,11 +227,10 @@ C_SIMPLE_HTTP_StaticFileInfo c_simple_http_get_file(
     // Close "read" side of pipe on "xdg-mime"'s side.
     posix_spawn_file_actions_addclose(actions, from_xdg_mime_pipe[0]);
 
-    buf_size = 256;
-    buf = malloc(buf_size);
+    uint64_t buf_size = 256;
+    char *buf = malloc(buf_size);
     uint64_t buf_idx = 0;
 
-    char *path_plus_idx = (char*)path + idx;
     pid_t pid;
     ret = posix_spawnp(&pid,
                        "xdg-mime",
@@ -256,7 +239,7 @@ C_SIMPLE_HTTP_StaticFileInfo c_simple_http_get_file(
                        (char *const[]){"xdg-mime",
                                        "query",
                                        "filetype",
-                                       path_plus_idx,
+                                       full_path,
                                        NULL},
                        environ);
     if (ret != 0) {
@@ -311,35 +294,6 @@ C_SIMPLE_HTTP_StaticFileInfo c_simple_http_get_file(
   return file_info;
 }
 
-int c_simple_http_static_validate_path(const char *path) {
-  uint64_t length = strlen(path);
-
-  if (length >= 3 && path[0] == '.' && path[1] == '.' && path[2] == '/') {
-    // Starts with "..", invalid.
-    return 1;
-  }
-
-  for (uint64_t idx = 0; idx <= length && path[idx] != 0; ++idx) {
-    if (length - idx >= 4) {
-      if (path[idx] == '/'
-          && path[idx + 1] == '.'
-          && path[idx + 2] == '.'
-          && path[idx + 3] == '/') {
-        // Contains "..", invalid.
-        return 1;
-      }
-    } else if (length - idx == 3) {
-      if (path[idx] == '/'
-          && path[idx + 1] == '.'
-          && path[idx + 2] == '.') {
-        // Ends with "..", invalid.
-        return 1;
-      }
-    }
-  }
-  return 0;
-}
-
 int c_simple_http_static_copy_over_dir(const char *from,
                                        const char *to,
                                        uint_fast8_t overwrite_enabled) {
@@ -45,11 +45,16 @@ void c_simple_http_cleanup_static_file_info(
 
 /// If ignore_mime_type is non-zero, then mime information will not be fetched.
 /// The mime_type string will therefore default to "application/octet-stream".
+/// If size_only is non-zero, the file is not read and "buf" is NULL, but
+/// "buf_size" is still its size.
+/// Paths with a ".." segment are rejected with STATIC_FILE_RESULT_InvalidPath.
+/// Paths that are not regular files (such as directories) are rejected with
+/// STATIC_FILE_RESULT_FileError.
 C_SIMPLE_HTTP_StaticFileInfo c_simple_http_get_file(
-  const char *static_dir, const char *path, int_fast8_t ignore_mime_type);
-
-/// Returns zero if OK.
-int c_simple_http_static_validate_path(const char *path);
+  const char *static_dir,
+  const char *path,
+  int_fast8_t ignore_mime_type,
+  int_fast8_t size_only);
 
 /// Copies all files in "from" into "to". Returns non-zero on failure.
 int c_simple_http_static_copy_over_dir(const char *from,
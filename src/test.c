@@ -7,8 +7,12 @@
 
 // POSIX includes.
 #include <unistd.h>
+#include <fcntl.h>
 #include <sys/types.h>
+#include <sys/socket.h>
 #include <dirent.h>
+#include <sys/un.h>
+#include <arpa/inet.h>
 
 // Local includes.
 #include "config.h"
@@ -17,7 +21,18 @@
 #include "http.h"
 #include "html_cache.h"
 #include "constants.h"
+#include "header_scan.h"
 #include "static.h"
+#include "output_queue.h"
+#include "timer_wheel.h"
+#include "connection_pool.h"
+#include "cpu_affinity.h"
+#include "listener.h"
+#include "rate_limit.h"
+#include "connection.h"
+#include "event_loop.h"
+#include "io_uring_backend.h"
+#include "globals.h"
 
 // Third party includes.
 #include <SimpleArchiver/src/helpers.h>
@@ -116,6 +131,27 @@ int test_internal_check_matching_string_in_list(
   return 0;
 }
 
+void test_internal_count_expired(C_SIMPLE_HTTP_TimerEntry *entry, void *ud) {
+  (void)entry;
+  ++*((size_t*)ud);
+}
+
+/// Returns the unsent bytes of "queue" as a c-string that must be free'd.
+char *test_internal_output_queue_to_string(
+    const C_SIMPLE_HTTP_OutputQueue *queue) {
+  struct iovec iovecs[C_SIMPLE_HTTP_OUTPUT_MAX_IOVECS];
+  int iovec_count = c_simple_http_output_queue_to_iovecs(
+    queue, iovecs, C_SIMPLE_HTTP_OUTPUT_MAX_IOVECS);
+  char *str = malloc(queue->size + 1);
+  size_t size = 0;
+  for (int idx = 0; idx < iovec_count; ++idx) {
+    memcpy(str + size, iovecs[idx].iov_base, iovecs[idx].iov_len);
+    size += iovecs[idx].iov_len;
+  }
+  str[size] = 0;
+  return str;
+}
+
 int main(int argc, char **argv) {
   // Test config.
   {
@@ -511,19 +547,229 @@ int main(int argc, char **argv) {
 
   // Test http.
   {
-    __attribute((cleanup(simple_archiver_hash_map_free)))
-    SDArchiverHashMap *headers_map = c_simple_http_request_to_headers_map(
-      "GET / HTTP/1.1\nUser-Agent: Blah\nHost: some host", 47);
-    ASSERT_TRUE(headers_map);
+    // Requests are parsed in place.
+    C_SIMPLE_HTTP_ParsedRequest headers_request;
+    char headers_raw[] = "GET / HTTP/1.1\nUser-Agent: Blah\nHost: some host";
+    ASSERT_TRUE(c_simple_http_parse_request(
+      headers_raw, sizeof(headers_raw) - 1, &headers_request) == 0);
+
+    const C_SIMPLE_HTTP_Header *header =
+      c_simple_http_request_get_header(&headers_request, "user-agent", 10);
+    ASSERT_TRUE(header);
+    CHECK_TRUE(header->value.size == 4);
+    CHECK_TRUE(memcmp(header->value.ptr, "Blah", 4) == 0);
+
+    header = c_simple_http_request_get_header(&headers_request, "HOST", 4);
+    ASSERT_TRUE(header);
+    CHECK_TRUE(header->value.size == 9);
+    CHECK_TRUE(memcmp(header->value.ptr, "some host", 9) == 0);
+    CHECK_FALSE(
+      c_simple_http_request_get_header(&headers_request, "hos", 3));
+
+    CHECK_FALSE(c_simple_http_request_connection_close(&headers_request));
+
+    // Known headers.
+    CHECK_TRUE(c_simple_http_known_header("Host", 4)
+               == C_SIMPLE_HTTP_KnownHeader_Host);
+    CHECK_TRUE(c_simple_http_known_header("IF-NONE-MATCH", 13)
+               == C_SIMPLE_HTTP_KnownHeader_IfNoneMatch);
+    CHECK_TRUE(c_simple_http_known_header("accept-encoding", 15)
+               == C_SIMPLE_HTTP_KnownHeader_AcceptEncoding);
+    CHECK_TRUE(c_simple_http_known_header("If-Modified-Since", 17)
+               == C_SIMPLE_HTTP_KnownHeader_IfModifiedSince);
+    CHECK_TRUE(c_simple_http_known_header("Range", 5)
+               == C_SIMPLE_HTTP_KnownHeader_Range);
+    CHECK_TRUE(c_simple_http_known_header("Post", 4)
+               == C_SIMPLE_HTTP_KnownHeader_Unknown);
+    CHECK_TRUE(c_simple_http_known_header("user-agent", 10)
+               == C_SIMPLE_HTTP_KnownHeader_Unknown);
+    CHECK_TRUE(c_simple_http_known_header("Hosts", 5)
+               == C_SIMPLE_HTTP_KnownHeader_Unknown);
+    char known_raw[] =
+      "GET / HTTP/1.1\r\nX: y\r\nrange: bytes=0-\r\nRANGE: bytes=1-\r\n\r\n";
+    ASSERT_TRUE(c_simple_http_parse_request(
+      known_raw, sizeof(known_raw) - 1, &headers_request) == 0);
+    header = c_simple_http_request_known_header(
+      &headers_request, C_SIMPLE_HTTP_KnownHeader_Range);
+    ASSERT_TRUE(header);
+    CHECK_TRUE(header == headers_request.headers + 1);
+    CHECK_TRUE(c_simple_http_request_get_header(&headers_request, "Range", 5)
+               == header);
+    CHECK_FALSE(c_simple_http_request_known_header(
+      &headers_request, C_SIMPLE_HTTP_KnownHeader_Host));
+    CHECK_TRUE(c_simple_http_request_get_header(&headers_request, "x", 1)
+               == headers_request.headers);
+
+    char close_raw[] =
+      "GET / HTTP/1.1\r\nConnection: Keep-Alive, Close\r\n\r\n";
+    ASSERT_TRUE(c_simple_http_parse_request(
+      close_raw, sizeof(close_raw) - 1, &headers_request) == 0);
+    CHECK_TRUE(c_simple_http_request_connection_close(&headers_request));
+
+    char keep_alive_raw[] =
+      "GET / HTTP/1.1\r\nConnection: keep-alive\r\n\r\n";
+    ASSERT_TRUE(c_simple_http_parse_request(
+      keep_alive_raw, sizeof(keep_alive_raw) - 1, &headers_request) == 0);
+    CHECK_FALSE(c_simple_http_request_connection_close(&headers_request));
+
+    // HTTP/1.0 is only kept alive if asked to.
+    char http_1_0_raw[] = "GET / HTTP/1.0\r\n\r\n";
+    ASSERT_TRUE(c_simple_http_parse_request(
+      http_1_0_raw, sizeof(http_1_0_raw) - 1, &headers_request) == 0);
+    CHECK_TRUE(c_simple_http_request_connection_close(&headers_request));
+    char http_1_0_keep_alive_raw[] =
+      "GET / HTTP/1.0\r\nConnection: Keep-Alive\r\n\r\n";
+    ASSERT_TRUE(c_simple_http_parse_request(
+      http_1_0_keep_alive_raw,
+      sizeof(http_1_0_keep_alive_raw) - 1,
+      &headers_request) == 0);
+    CHECK_FALSE(c_simple_http_request_connection_close(&headers_request));
+    CHECK_FALSE(c_simple_http_request_is_head(&headers_request));
+
+    char head_raw[] = "HEAD /inner HTTP/1.1\r\n\r\n";
+    ASSERT_TRUE(c_simple_http_parse_request(
+      head_raw, sizeof(head_raw) - 1, &headers_request) == 0);
+    CHECK_TRUE(c_simple_http_request_is_head(&headers_request));
+
+    CHECK_TRUE(c_simple_http_request_headers_end(
+                 "GET / HTTP/1.1\r\n", 16, NULL)
+               == 0);
+    CHECK_TRUE(c_simple_http_request_headers_end(
+                 "GET / HTTP/1.1\r\nHost: a\r\n\r\nGET /", 32, NULL)
+               == 27);
+    CHECK_TRUE(c_simple_http_request_headers_end(
+                 "GET / HTTP/1.1\nHost: a\n\nGET /", 29, NULL)
+               == 24);
+    {
+      // Search resumes where it left off as the request is received.
+      const char *request = "GET / HTTP/1.1\r\nHost: a\r\n\r\n";
+      size_t scan_idx = 0;
+      CHECK_TRUE(c_simple_http_request_headers_end(request, 25, &scan_idx)
+                 == 0);
+      CHECK_TRUE(scan_idx == 23);
+      CHECK_TRUE(c_simple_http_request_headers_end(request, 26, &scan_idx)
+                 == 0);
+      CHECK_TRUE(scan_idx == 24);
+      CHECK_TRUE(c_simple_http_request_headers_end(request, 27, &scan_idx)
+                 == 27);
+    }
 
-    const char *ret =
-      simple_archiver_hash_map_get(headers_map, "user-agent", 11);
-    ASSERT_TRUE(ret);
-    CHECK_STREQ(ret, "User-Agent: Blah");
+    {
+      C_SIMPLE_HTTP_ParsedRequest request;
+      char raw[] = "GET /a%20b//c/?d=e HTTP/1.1\r\n"
+                   "Host:  some host \r\n"
+                   "not a header\r\n"
+                   "User-Agent:curl\r\n"
+                   "\r\n"
+                   "Ignored: after headers\r\n";
+      ASSERT_TRUE(c_simple_http_parse_request(raw, sizeof(raw) - 1, &request)
+                  == 0);
+      CHECK_TRUE(request.method.ptr == raw);
+      CHECK_TRUE(request.method.size == 3);
+      CHECK_TRUE(request.path.ptr == raw + 4);
+      CHECK_TRUE(request.path.size == 6);
+      CHECK_STREQ(request.path.ptr, "/a b/c");
+      CHECK_TRUE(request.version.size == 8);
+      CHECK_TRUE(memcmp(request.version.ptr, "HTTP/1.1", 8) == 0);
+      ASSERT_TRUE(request.header_count == 2);
+      CHECK_TRUE(request.headers[0].name.size == 4);
+      CHECK_TRUE(memcmp(request.headers[0].name.ptr, "Host", 4) == 0);
+      CHECK_TRUE(request.headers[0].value.size == 9);
+      CHECK_TRUE(memcmp(request.headers[0].value.ptr, "some host", 9) == 0);
+      CHECK_TRUE(request.headers[1].value.size == 4);
+      CHECK_TRUE(memcmp(request.headers[1].value.ptr, "curl", 4) == 0);
+
+      // Paths are not limited to a fixed size buffer.
+      char long_raw[1024];
+      memset(long_raw, 'a', sizeof(long_raw));
+      memcpy(long_raw, "GET /", 5);
+      memcpy(long_raw + sizeof(long_raw) - 11, " HTTP/1.1\n\n", 11);
+      ASSERT_TRUE(
+        c_simple_http_parse_request(long_raw, sizeof(long_raw), &request)
+        == 0);
+      CHECK_TRUE(request.path.size == sizeof(long_raw) - 15);
+      CHECK_TRUE(request.header_count == 0);
+
+      char no_version_raw[] = "GET /\r\n\r\n";
+      CHECK_TRUE(c_simple_http_parse_request(
+                   no_version_raw, sizeof(no_version_raw) - 1, &request)
+                 == 1);
+      char empty_raw[] = "\r\n";
+      CHECK_TRUE(c_simple_http_parse_request(empty_raw, 2, &request) == 1);
+      char dot_dot_raw[] = "GET /a/%2E%2e/b HTTP/1.1\r\n\r\n";
+      CHECK_TRUE(c_simple_http_parse_request(
+                   dot_dot_raw, sizeof(dot_dot_raw) - 1, &request)
+                 == 1);
+
+      char many_raw[C_SIMPLE_HTTP_MAX_HEADERS * 5 + 32];
+      size_t many_size = 0;
+      memcpy(many_raw, "GET / HTTP/1.1\n", 15);
+      many_size += 15;
+      for (size_t idx = 0; idx <= C_SIMPLE_HTTP_MAX_HEADERS; ++idx) {
+        memcpy(many_raw + many_size, "a: b\n", 5);
+        many_size += 5;
+      }
+      many_raw[many_size++] = '\n';
+      CHECK_TRUE(
+        c_simple_http_parse_request(many_raw, many_size, &request) == 2);
+      // The path was normalised in place.
+      memcpy(many_raw, "GET / HTTP/1.1\n", 15);
+      CHECK_TRUE(
+        c_simple_http_parse_request(many_raw, many_size - 6, &request) == 0);
+      CHECK_TRUE(request.header_count == C_SIMPLE_HTTP_MAX_HEADERS);
+    }
 
-    ret = simple_archiver_hash_map_get(headers_map, "host", 5);
-    ASSERT_TRUE(ret);
-    CHECK_STREQ(ret, "Host: some host");
+    // Each header scan kernel the CPU supports finds the same bytes.
+    {
+      char scan_buf[100];
+      for (size_t idx = 0; idx < sizeof(scan_buf); ++idx) {
+        scan_buf[idx] = (char)('a' + idx % 26);
+      }
+      const enum C_SIMPLE_HTTP_HeaderScanKernel kernels[3] = {
+        C_SIMPLE_HTTP_HeaderScan_Scalar,
+        C_SIMPLE_HTTP_HeaderScan_SSE2,
+        C_SIMPLE_HTTP_HeaderScan_AVX2,
+      };
+      for (size_t kernel_idx = 0; kernel_idx < 3; ++kernel_idx) {
+        if (c_simple_http_header_scan_use(kernels[kernel_idx]) != 0) {
+          printf("NOTICE header scan kernel %zu is not supported\n",
+                 kernel_idx);
+          continue;
+        }
+        CHECK_TRUE(c_simple_http_header_scan_kernel() == kernels[kernel_idx]);
+        uint_fast8_t all_found = 1;
+        for (size_t target = 0; target < sizeof(scan_buf); ++target) {
+          scan_buf[target] = ':';
+          for (size_t offset = 0; offset <= target; ++offset) {
+            if (c_simple_http_header_scan_find(scan_buf + offset,
+                                               sizeof(scan_buf) - offset,
+                                               '\n',
+                                               ':')
+                != target - offset) {
+              all_found = 0;
+            }
+          }
+          if (c_simple_http_header_scan_find(scan_buf, target, '\n', ':')
+              != target) {
+            all_found = 0;
+          }
+          scan_buf[target] = (char)('a' + target % 26);
+        }
+        CHECK_TRUE(all_found);
+
+        C_SIMPLE_HTTP_ParsedRequest request;
+        char raw[] = "GET / HTTP/1.1\r\n"
+                     "Cookie: aaaaaaaaaaaaaaaaaaaa"
+                     "aaaaaaaaaaaaaaaaaaaaa\r\n"
+                     "Host:a\r\n\r\n";
+        ASSERT_TRUE(c_simple_http_parse_request(raw, sizeof(raw) - 1, &request)
+                    == 0);
+        ASSERT_TRUE(request.header_count == 2);
+        CHECK_TRUE(request.headers[0].value.size == 41);
+        CHECK_TRUE(request.headers[1].value.size == 1);
+      }
+      c_simple_http_header_scan_init();
+    }
 
     char *stripped_path_buf = c_simple_http_strip_path("/", 1);
     CHECK_STREQ(stripped_path_buf, "/");
@@ -575,6 +821,43 @@ int main(int argc, char **argv) {
     //printf("stripped path: %s\n", stripped_path_buf);
     CHECK_STREQ(stripped_path_buf, "/someurl/inner");
     free(stripped_path_buf);
+
+    {
+      char path[] = "/%2F%2fa//b%3F/?c=d%00";
+      size_t path_size = sizeof(path) - 1;
+      CHECK_TRUE(c_simple_http_normalize_path(path, &path_size, 3) == 0);
+      CHECK_TRUE(path_size == 5);
+      CHECK_STREQ(path, "/a/b?");
+
+      char truncated_path[] = "/a%2";
+      path_size = sizeof(truncated_path) - 1;
+      CHECK_TRUE(
+        c_simple_http_normalize_path(truncated_path, &path_size, 1) == 1);
+      char truncated_path_2[] = "/a%";
+      path_size = sizeof(truncated_path_2) - 1;
+      CHECK_TRUE(
+        c_simple_http_normalize_path(truncated_path_2, &path_size, 1) == 1);
+      // Not decoded, so not an escape.
+      path_size = sizeof(truncated_path) - 1;
+      memcpy(truncated_path, "/a%2", path_size);
+      CHECK_TRUE(
+        c_simple_http_normalize_path(truncated_path, &path_size, 0) == 0);
+      CHECK_STREQ(truncated_path, "/a%2");
+
+      char invalid_path[] = "/a%zz";
+      path_size = sizeof(invalid_path) - 1;
+      CHECK_TRUE(
+        c_simple_http_normalize_path(invalid_path, &path_size, 1) == 1);
+
+      char dot_dot_path[] = "/a/..//";
+      path_size = sizeof(dot_dot_path) - 1;
+      CHECK_TRUE(
+        c_simple_http_normalize_path(dot_dot_path, &path_size, 2) == 2);
+      path_size = sizeof(dot_dot_path) - 1;
+      CHECK_TRUE(
+        c_simple_http_normalize_path(dot_dot_path, &path_size, 0) == 0);
+      CHECK_STREQ(dot_dot_path, "/a/..");
+    }
   }
 
   // Test helpers.
@@ -606,16 +889,6 @@ int main(int argc, char **argv) {
     hex_result = c_simple_http_helper_hex_to_value('4', '1');
     CHECK_TRUE(hex_result == 'A');
 
-    buf = c_simple_http_helper_unescape_uri("%2fderp%2Fdoop%21");
-    CHECK_TRUE(strcmp(buf, "/derp/doop!") == 0);
-    free(buf);
-    buf = NULL;
-
-    buf = c_simple_http_helper_unescape_uri("%41%42%43%25%5A%5a");
-    CHECK_TRUE(strcmp(buf, "ABC%ZZ") == 0);
-    free(buf);
-    buf = NULL;
-
     DIR *dirp = opendir("/tmp/create_dirs_dir");
     uint_fast8_t dir_exists = dirp ? 1 : 0;
     closedir(dirp);
@@ -866,7 +1139,9 @@ int main(int argc, char **argv) {
       "/tmp/c_simple_http_cache_dir",
       &templates,
       0xFFFFFFFF,
-      &buf);
+      0,
+      &buf,
+      NULL);
 
     CHECK_TRUE(int_ret > 0);
     ASSERT_TRUE(buf);
@@ -889,7 +1164,9 @@ int main(int argc, char **argv) {
       "/tmp/c_simple_http_cache_dir",
       &templates,
       0xFFFFFFFF,
-      &buf);
+      0,
+      &buf,
+      NULL);
     CHECK_TRUE(int_ret == 0);
     ASSERT_TRUE(buf);
     CHECK_TRUE(strcmp(buf, "<body>Some test text.<br>Yep.</body>\n") == 0);
@@ -905,6 +1182,48 @@ int main(int argc, char **argv) {
     ASSERT_TRUE(cache_file_exists);
     CHECK_TRUE(cache_file_size_0 == cache_file_size_1);
 
+    // Only the size of an up to date entry.
+    size_t html_size = 0;
+    int_ret = c_simple_http_cache_path(
+      "/",
+      test_http_template_filename5,
+      "/tmp/c_simple_http_cache_dir",
+      &templates,
+      0xFFFFFFFF,
+      0,
+      NULL,
+      &html_size);
+    CHECK_TRUE(int_ret == 0);
+    CHECK_TRUE(html_size == strlen("<body>Some test text.<br>Yep.</body>\n"));
+
+    // Read only, the up to date entry is still read.
+    html_size = 0;
+    int_ret = c_simple_http_cache_path(
+      "/",
+      test_http_template_filename5,
+      "/tmp/c_simple_http_cache_dir",
+      &templates,
+      0xFFFFFFFF,
+      1,
+      &buf,
+      &html_size);
+    CHECK_TRUE(int_ret == 0);
+    ASSERT_TRUE(buf);
+    CHECK_TRUE(strcmp(buf, "<body>Some test text.<br>Yep.</body>\n") == 0);
+    CHECK_TRUE(html_size == strlen(buf));
+    free(buf);
+    buf = NULL;
+    CHECK_TRUE(c_simple_http_cache_path(
+                 "/not_in_config",
+                 test_http_template_filename5,
+                 "/tmp/c_simple_http_cache_dir",
+                 &templates,
+                 0xFFFFFFFF,
+                 1,
+                 NULL,
+                 &html_size)
+               < 0);
+
     // Change a file used by the template for PATH=/ .
     // Sleep first since granularity is by the second.
     puts("Sleeping for two seconds to ensure edited file's timestamp has "
@@ -923,6 +1242,24 @@ int main(int argc, char **argv) {
       == 28);
     fclose(test_file);
 
+    // Read only, the out of date entry is left as is.
+    int_ret = c_simple_http_cache_path(
+      "/",
+      test_http_template_filename5,
+      "/tmp/c_simple_http_cache_dir",
+      &templates,
+      0xFFFFFFFF,
+      1,
+      &buf,
+      NULL);
+    CHECK_TRUE(int_ret == 2);
+    CHECK_FALSE(buf);
+    cache_file = fopen("/tmp/c_simple_http_cache_dir/ROOT", "r");
+    ASSERT_TRUE(cache_file);
+    fseek(cache_file, 0, SEEK_END);
+    CHECK_TRUE(ftell(cache_file) == cache_file_size_0);
+    fclose(cache_file);
+
     // Re-run cache function, checking that it is invalidated.
     int_ret = c_simple_http_cache_path(
       "/",
@@ -930,7 +1267,9 @@ int main(int argc, char **argv) {
       "/tmp/c_simple_http_cache_dir",
       &templates,
       0xFFFFFFFF,
-      &buf);
+      0,
+      &buf,
+      NULL);
     CHECK_TRUE(int_ret > 0);
     ASSERT_TRUE(buf);
     CHECK_TRUE(strcmp(buf, "<body>Alternate test text.<br>Yep.</body>\n") == 0);
@@ -953,7 +1292,9 @@ int main(int argc, char **argv) {
       "/tmp/c_simple_http_cache_dir",
       &templates,
       0xFFFFFFFF,
-      &buf);
+      0,
+      &buf,
+      NULL);
     CHECK_TRUE(int_ret == 0);
     ASSERT_TRUE(buf);
     CHECK_TRUE(strcmp(buf, "<body>Alternate test text.<br>Yep.</body>\n") == 0);
@@ -1001,7 +1342,9 @@ int main(int argc, char **argv) {
       "/tmp/c_simple_http_cache_dir",
       &templates,
       0xFFFFFFFF,
-      &buf);
+      0,
+      &buf,
+      NULL);
     CHECK_TRUE(int_ret > 0);
     ASSERT_TRUE(buf);
     CHECK_TRUE(strcmp(buf, "<h1>Alternate test text.<br>Yep.</h1>") == 0);
@@ -1018,7 +1361,9 @@ int main(int argc, char **argv) {
       "/tmp/c_simple_http_cache_dir",
       &templates,
       1,
-      &buf);
+      0,
+      &buf,
+      NULL);
     CHECK_TRUE(int_ret > 0);
     ASSERT_TRUE(buf);
     CHECK_TRUE(strcmp(buf, "<h1>Alternate test text.<br>Yep.</h1>") == 0);
@@ -1041,7 +1386,8 @@ int main(int argc, char **argv) {
     if (is_xdg_mime_exists) {
       CHECK_TRUE(c_simple_http_is_xdg_mime_available());
 
-      C_SIMPLE_HTTP_StaticFileInfo info = c_simple_http_get_file(".", argv[0], 0);
+      C_SIMPLE_HTTP_StaticFileInfo info =
+        c_simple_http_get_file(".", argv[0], 0, 0);
       CHECK_TRUE(info.buf);
       CHECK_TRUE(info.buf_size > 0);
       CHECK_TRUE(info.mime_type);
@@ -1052,7 +1398,8 @@ int main(int argc, char **argv) {
       CHECK_FALSE(c_simple_http_is_xdg_mime_available());
     }
 
-    C_SIMPLE_HTTP_StaticFileInfo info = c_simple_http_get_file(".", argv[0], 1);
+    C_SIMPLE_HTTP_StaticFileInfo info =
+        c_simple_http_get_file(".", argv[0], 1, 0);
     CHECK_TRUE(info.buf);
     CHECK_TRUE(info.buf_size > 0);
     CHECK_TRUE(info.mime_type);
@@ -1060,10 +1407,790 @@ int main(int argc, char **argv) {
     CHECK_STREQ(info.mime_type, "application/octet-stream");
     c_simple_http_cleanup_static_file_info(&info);
 
-    CHECK_TRUE(c_simple_http_static_validate_path("../derp") != 0);
-    CHECK_TRUE(c_simple_http_static_validate_path("./derp") == 0);
-    CHECK_TRUE(c_simple_http_static_validate_path("./../derp") != 0);
-    CHECK_TRUE(c_simple_http_static_validate_path("/derp/..") != 0);
+    // Only the size is looked up for HEAD requests.
+    info = c_simple_http_get_file(".", argv[0], 1, 0);
+    const uint64_t file_size = info.buf_size;
+    c_simple_http_cleanup_static_file_info(&info);
+    info = c_simple_http_get_file(".", argv[0], 1, 1);
+    CHECK_FALSE(info.buf);
+    CHECK_TRUE(info.buf_size == file_size);
+    CHECK_TRUE(info.result == STATIC_FILE_RESULT_OK);
+    c_simple_http_cleanup_static_file_info(&info);
+
+    // Directories are not served, with or without "size_only".
+    info = c_simple_http_get_file("/", "/tmp", 1, 0);
+    CHECK_FALSE(info.buf);
+    CHECK_TRUE(info.result == STATIC_FILE_RESULT_FileError);
+    c_simple_http_cleanup_static_file_info(&info);
+    info = c_simple_http_get_file("/", "/tmp", 1, 1);
+    CHECK_TRUE(info.result == STATIC_FILE_RESULT_FileError);
+    c_simple_http_cleanup_static_file_info(&info);
+
+    CHECK_TRUE(c_simple_http_path_has_dot_dot("../derp") != 0);
+    CHECK_TRUE(c_simple_http_path_has_dot_dot("./derp") == 0);
+    CHECK_TRUE(c_simple_http_path_has_dot_dot("./../derp") != 0);
+    CHECK_TRUE(c_simple_http_path_has_dot_dot("/derp/..") != 0);
+    CHECK_TRUE(c_simple_http_path_has_dot_dot("..") != 0);
+    CHECK_TRUE(c_simple_http_path_has_dot_dot("/derp/...") == 0);
+    info = c_simple_http_get_file(".", "/src/../src/test.c", 1, 0);
+    CHECK_TRUE(info.result == STATIC_FILE_RESULT_InvalidPath);
+    c_simple_http_cleanup_static_file_info(&info);
+  }
+
+  // Test output queue.
+  {
+    C_SIMPLE_HTTP_OutputQueue queue;
+    memset(&queue, 0, sizeof(C_SIMPLE_HTTP_OutputQueue));
+
+    char *owned = malloc(40);
+    memcpy(owned, "0123456789012345678901234567890123456789", 40);
+    CHECK_TRUE(c_simple_http_output_queue_add_ref(&queue, "Header: ", 8) == 0);
+    CHECK_TRUE(c_simple_http_output_queue_add_copy(&queue, "12\n\n", 4) == 0);
+    CHECK_TRUE(c_simple_http_output_queue_add_owned(&queue, owned, 40) == 0);
+    CHECK_TRUE(queue.size == 52);
+
+    struct iovec iovecs[C_SIMPLE_HTTP_OUTPUT_MAX_IOVECS];
+    int iovec_count = c_simple_http_output_queue_to_iovecs(
+      &queue, iovecs, C_SIMPLE_HTTP_OUTPUT_MAX_IOVECS);
+    ASSERT_TRUE(iovec_count == 3);
+    CHECK_TRUE(iovecs[0].iov_len == 8);
+    CHECK_TRUE(memcmp(iovecs[1].iov_base, "12\n\n", 4) == 0);
+    CHECK_TRUE(iovecs[2].iov_base == owned);
+
+    // Partially sent.
+    c_simple_http_output_queue_consume(&queue, 10);
+    CHECK_TRUE(queue.size == 42);
+    iovec_count = c_simple_http_output_queue_to_iovecs(
+      &queue, iovecs, C_SIMPLE_HTTP_OUTPUT_MAX_IOVECS);
+    ASSERT_TRUE(iovec_count == 2);
+    CHECK_TRUE(iovecs[0].iov_len == 2);
+    CHECK_TRUE(memcmp(iovecs[0].iov_base, "\n\n", 2) == 0);
+
+    struct msghdr *msg = c_simple_http_output_queue_to_msg(&queue);
+    ASSERT_TRUE(msg);
+    CHECK_TRUE(msg->msg_iovlen == 2);
+
+    c_simple_http_output_queue_consume(&queue, 42);
+    CHECK_TRUE(queue.size == 0);
+    CHECK_TRUE(c_simple_http_output_queue_to_iovecs(
+      &queue, iovecs, C_SIMPLE_HTTP_OUTPUT_MAX_IOVECS) == 0);
+
+    c_simple_http_output_queue_cleanup(&queue);
+  }
+
+  // Test timer wheel.
+  {
+    struct timespec now;
+    memset(&now, 0, sizeof(struct timespec));
+    now.tv_sec = 100;
+    C_SIMPLE_HTTP_TimerWheel wheel;
+    c_simple_http_timer_wheel_init(&wheel, &now);
+    CHECK_TRUE(c_simple_http_timer_wheel_next_timeout(&wheel, &now) == -1);
+
+    C_SIMPLE_HTTP_TimerEntry entries[3];
+    memset(entries, 0, sizeof(entries));
+    CHECK_FALSE(c_simple_http_timer_is_scheduled(&entries[0]));
+    c_simple_http_timer_wheel_schedule(&wheel, &entries[0], &now, 3000);
+    c_simple_http_timer_wheel_schedule(&wheel, &entries[1], &now, 1000);
+    // More than a full turn of the wheel.
+    c_simple_http_timer_wheel_schedule(
+      &wheel,
+      &entries[2],
+      &now,
+      C_SIMPLE_HTTP_TIMER_WHEEL_TICK_MILLIS * C_SIMPLE_HTTP_TIMER_WHEEL_SLOTS
+        + 3000);
+    CHECK_TRUE(c_simple_http_timer_is_scheduled(&entries[0]));
+    CHECK_TRUE(c_simple_http_timer_wheel_next_timeout(&wheel, &now) == 1000);
+
+    c_simple_http_timer_cancel(&entries[1]);
+    CHECK_FALSE(c_simple_http_timer_is_scheduled(&entries[1]));
+    CHECK_TRUE(c_simple_http_timer_wheel_next_timeout(&wheel, &now) == 3000);
+
+    size_t expired = 0;
+    now.tv_sec += 2;
+    c_simple_http_timer_wheel_expire(
+      &wheel, &now, test_internal_count_expired, &expired);
+    CHECK_TRUE(expired == 0);
+
+    now.tv_sec += 1;
+    c_simple_http_timer_wheel_expire(
+      &wheel, &now, test_internal_count_expired, &expired);
+    CHECK_TRUE(expired == 1);
+    CHECK_FALSE(c_simple_http_timer_is_scheduled(&entries[0]));
+    CHECK_TRUE(c_simple_http_timer_is_scheduled(&entries[2]));
+
+    // The entry a full turn ahead only expires on its own tick.
+    now.tv_sec += C_SIMPLE_HTTP_TIMER_WHEEL_TICK_MILLIS
+      * C_SIMPLE_HTTP_TIMER_WHEEL_SLOTS / 1000 - 1;
+    c_simple_http_timer_wheel_expire(
+      &wheel, &now, test_internal_count_expired, &expired);
+    CHECK_TRUE(expired == 1);
+    now.tv_sec += 2;
+    c_simple_http_timer_wheel_expire(
+      &wheel, &now, test_internal_count_expired, &expired);
+    CHECK_TRUE(expired == 2);
+    CHECK_TRUE(c_simple_http_timer_wheel_next_timeout(&wheel, &now) == -1);
+  }
+
+  // Test connection pool.
+  {
+    C_SIMPLE_HTTP_ConnectionPool pool;
+    ASSERT_TRUE(c_simple_http_connection_pool_init(&pool, 2) == 0);
+    int fds_a[2];
+    int fds_b[2];
+    ASSERT_TRUE(pipe(fds_a) == 0);
+    ASSERT_TRUE(pipe(fds_b) == 0);
+
+    ConnectionItem *first = c_simple_http_connection_pool_acquire(&pool,
+                                                                  fds_a[0]);
+    ConnectionItem *second = c_simple_http_connection_pool_acquire(&pool,
+                                                                   fds_b[0]);
+    ASSERT_TRUE(first);
+    ASSERT_TRUE(second);
+    CHECK_TRUE(first != second);
+    CHECK_TRUE(c_simple_http_connection_pool_count(&pool) == 2);
+    CHECK_TRUE(first->fd == fds_a[0]);
+    CHECK_TRUE(second->fd == fds_b[0]);
+    // Exhausted.
+    CHECK_FALSE(c_simple_http_connection_pool_acquire(&pool, fds_a[1]));
+
+    // Released items are reused with their buffers.
+    CHECK_TRUE(c_simple_http_buffer_append(&first->in, "GET", 3) == 0);
+    char *in_buf = first->in.buf;
+    c_simple_http_connection_pool_release(&pool, first);
+    CHECK_TRUE(first->fd == -1);
+    CHECK_TRUE(c_simple_http_connection_pool_count(&pool) == 1);
+    ConnectionItem *third = c_simple_http_connection_pool_acquire(&pool,
+                                                                  fds_a[1]);
+    CHECK_TRUE(third == first);
+    CHECK_TRUE(third->in.buf == in_buf);
+    CHECK_TRUE(third->in.size == 0);
+    CHECK_TRUE(third->fd == fds_a[1]);
+
+    // Unsent bytes are counted for the whole pool.
+    CHECK_TRUE(pool.queued_bytes == 0);
+    CHECK_TRUE(c_simple_http_output_queue_add_ref(&third->out, "abcd", 4) == 0);
+    CHECK_TRUE(c_simple_http_output_queue_add_copy(&second->out, "ef", 2) == 0);
+    CHECK_TRUE(pool.queued_bytes == 6);
+    c_simple_http_output_queue_consume(&third->out, 3);
+    CHECK_TRUE(pool.queued_bytes == 3);
+    c_simple_http_connection_pool_release(&pool, second);
+    CHECK_TRUE(pool.queued_bytes == 1);
+
+    c_simple_http_connection_pool_cleanup(&pool);
+    close(fds_b[1]);
+  }
+
+  // Test connection timeouts.
+  {
+    Args args;
+    memset(&args, 0, sizeof(Args));
+    args.header_timeout_seconds = 3;
+    args.idle_timeout_seconds = 5;
+    args.keep_alive_timeout_seconds = 7;
+    ConnectionContext ctx;
+    memset(&ctx, 0, sizeof(ConnectionContext));
+    ctx.args = &args;
+    ctx.current_time.tv_sec = 11;
+    ConnectionItem citem;
+    memset(&citem, 0, sizeof(ConnectionItem));
+    citem.fd = -1;
+    citem.time_point.tv_sec = 10;
+    citem.request_time.tv_sec = 10;
+
+    // Receiving a request's headers.
+    citem.flags = 0x40;
+    CHECK_TRUE(c_simple_http_connection_timeout_remaining(&citem, &ctx)
+               == 2000);
+    args.min_recv_rate = 100;
+    // Nothing received yet, only the header timeout applies.
+    CHECK_TRUE(c_simple_http_connection_timeout_remaining(&citem, &ctx)
+               == 2000);
+    // Too slow after the grace period.
+    citem.request_bytes = 50;
+    CHECK_TRUE(c_simple_http_connection_timeout_remaining(&citem, &ctx)
+               == 0);
+    citem.request_bytes = 250;
+    CHECK_TRUE(c_simple_http_connection_timeout_remaining(&citem, &ctx)
+               == 1500);
+
+    // Sending a response.
+    CHECK_TRUE(c_simple_http_output_queue_add_ref(&citem.out, "abc", 3) == 0);
+    CHECK_TRUE(c_simple_http_connection_timeout_remaining(&citem, &ctx)
+               == 4000);
+    c_simple_http_output_queue_clear(&citem.out);
+
+    // Waiting for the next request.
+    citem.flags = 0;
+    CHECK_TRUE(c_simple_http_connection_timeout_remaining(&citem, &ctx)
+               == 6000);
+    c_simple_http_cleanup_connection_item(&citem);
+  }
+
+  // Test connection input handling.
+  {
+    __attribute__((cleanup(test_internal_cleanup_delete_temporary_file)))
+    const char *test_connection_config_filename =
+      "/tmp/c_simple_http_connection_test.config";
+    FILE *test_file = fopen(test_connection_config_filename, "w");
+    ASSERT_TRUE(test_file);
+    ASSERT_TRUE(
+      fputs("PATH=/\nHTML=<p>Root</p>\nPATH=/b\nHTML=<p>B</p>\n", test_file)
+      >= 0);
+    fclose(test_file);
+
+    __attribute__((cleanup(c_simple_http_clean_up_parsed_config)))
+    C_SIMPLE_HTTP_ParsedConfig parsed = c_simple_http_parse_config(
+      test_connection_config_filename, "PATH", NULL);
+    ASSERT_TRUE(parsed.paths);
+
+    Args args;
+    memset(&args, 0, sizeof(Args));
+    args.flags = 1;
+    args.keep_alive_max_requests = 100;
+    ConnectionContext ctx;
+    memset(&ctx, 0, sizeof(ConnectionContext));
+    ctx.args = &args;
+    ctx.parsed = &parsed;
+    ctx.current_time.tv_sec = 10;
+    __attribute__((cleanup(c_simple_http_cleanup_connection_item)))
+    ConnectionItem citem;
+    memset(&citem, 0, sizeof(ConnectionItem));
+    citem.fd = -1;
+
+    const char *root_response =
+      "HTTP/1.1 200 OK\nAllow: GET, HEAD\nConnection: keep-alive\n"
+      "Content-Type: text/html\nContent-Length: 11\n\n<p>Root</p>";
+    const char *b_response =
+      "HTTP/1.1 200 OK\nAllow: GET, HEAD\nConnection: keep-alive\n"
+      "Content-Type: text/html\nContent-Length: 8\n\n<p>B</p>";
+    __attribute__((cleanup(simple_archiver_helper_cleanup_c_string)))
+    char *out_str = NULL;
+
+    // Pipelined requests are responded to in order, keeping the start of the
+    // next request.
+    {
+      char pipelined[] = "GET / HTTP/1.1\r\nHost: a\r\n\r\n"
+                         "GET /b HTTP/1.1\r\nHost: a\r\n\r\n"
+                         "GET / HTTP/1.1\r\n\r\n"
+                         "GET /b HT";
+      CHECK_TRUE(c_simple_http_connection_handle_input(
+                   &citem, &ctx, pipelined, sizeof(pipelined) - 1)
+                 == 0);
+      char expected[512];
+      snprintf(expected,
+               sizeof(expected),
+               "%s%s%s",
+               root_response,
+               b_response,
+               root_response);
+      out_str = test_internal_output_queue_to_string(&citem.out);
+      CHECK_STREQ(out_str, expected);
+      simple_archiver_helper_cleanup_c_string(&out_str);
+      CHECK_TRUE(citem.request_count == 3);
+      CHECK_TRUE(citem.in.size == 9);
+      CHECK_TRUE(memcmp(citem.in.buf, "GET /b HT", 9) == 0);
+      CHECK_TRUE((citem.flags & 0x40) != 0);
+      c_simple_http_output_queue_clear(&citem.out);
+
+      // The rest of the kept request.
+      char rest[] = "TP/1.1\r\n\r\n";
+      CHECK_TRUE(c_simple_http_connection_handle_input(
+                   &citem, &ctx, rest, sizeof(rest) - 1)
+                 == 0);
+      out_str = test_internal_output_queue_to_string(&citem.out);
+      CHECK_STREQ(out_str, b_response);
+      simple_archiver_helper_cleanup_c_string(&out_str);
+      CHECK_TRUE(citem.request_count == 4);
+      CHECK_TRUE(citem.in.size == 0);
+      CHECK_FALSE(citem.flags & 0x40);
+      c_simple_http_output_queue_clear(&citem.out);
+    }
+
+    // A request split over several reads is buffered, and the search for the
+    // end of its headers resumes where it left off.
+    {
+      char first[] = "GET /b HTTP/1.1\r\nHo";
+      CHECK_TRUE(c_simple_http_connection_handle_input(
+                   &citem, &ctx, first, sizeof(first) - 1)
+                 == 0);
+      CHECK_TRUE(citem.out.size == 0);
+      CHECK_TRUE(citem.in.size == sizeof(first) - 1);
+      CHECK_TRUE(memcmp(citem.in.buf, "GET /b HTTP/1.1\r\nHo", 19) == 0);
+      CHECK_TRUE(citem.in_scan > 0);
+      CHECK_TRUE((citem.flags & 0x40) != 0);
+      const size_t first_scan = citem.in_scan;
+
+      char second[] = "st: a\r\n\r";
+      CHECK_TRUE(c_simple_http_connection_handle_input(
+                   &citem, &ctx, second, sizeof(second) - 1)
+                 == 0);
+      CHECK_TRUE(citem.out.size == 0);
+      CHECK_TRUE(citem.in.size == 27);
+      CHECK_TRUE(citem.in_scan > first_scan);
+
+      char third[] = "\n";
+      CHECK_TRUE(c_simple_http_connection_handle_input(
+                   &citem, &ctx, third, 1)
+                 == 0);
+      out_str = test_internal_output_queue_to_string(&citem.out);
+      CHECK_STREQ(out_str, b_response);
+      simple_archiver_helper_cleanup_c_string(&out_str);
+      CHECK_TRUE(citem.in.size == 0);
+      CHECK_TRUE(citem.in_scan == 0);
+      CHECK_FALSE(citem.flags & 0x40);
+      c_simple_http_output_queue_clear(&citem.out);
+    }
+
+    // Empty lines before a request are skipped.
+    {
+      char empty_lines[] = "\r\n\n";
+      CHECK_TRUE(c_simple_http_connection_handle_input(
+                   &citem, &ctx, empty_lines, sizeof(empty_lines) - 1)
+                 == 0);
+      CHECK_TRUE(citem.out.size == 0);
+      CHECK_TRUE(citem.in.size == 0);
+
+      char leading[] = "\r\n\r\nGET / HTTP/1.1\r\n\r\n\r\n";
+      CHECK_TRUE(c_simple_http_connection_handle_input(
+                   &citem, &ctx, leading, sizeof(leading) - 1)
+                 == 0);
+      out_str = test_internal_output_queue_to_string(&citem.out);
+      CHECK_STREQ(out_str, root_response);
+      simple_archiver_helper_cleanup_c_string(&out_str);
+      CHECK_TRUE(citem.in.size == 0);
+      c_simple_http_output_queue_clear(&citem.out);
+    }
+
+    // Headers that do not end within C_SIMPLE_HTTP_MAX_REQUEST_SIZE.
+    {
+      char chunk[1024];
+      memset(chunk, 'a', sizeof(chunk));
+      memcpy(chunk, "GET / HTTP/1.1\r\nX: ", 19);
+      size_t received = 0;
+      int ret = 0;
+      while (ret == 0 && received <= C_SIMPLE_HTTP_MAX_REQUEST_SIZE) {
+        ret = c_simple_http_connection_handle_input(
+          &citem, &ctx, chunk, sizeof(chunk));
+        received += sizeof(chunk);
+        // Only the first chunk has the request line.
+        memset(chunk, 'a', 19);
+      }
+      CHECK_TRUE(ret != 0);
+      CHECK_TRUE(received > C_SIMPLE_HTTP_MAX_REQUEST_SIZE);
+      CHECK_TRUE(received - sizeof(chunk) <= C_SIMPLE_HTTP_MAX_REQUEST_SIZE);
+      out_str = test_internal_output_queue_to_string(&citem.out);
+      CHECK_TRUE(strncmp(out_str, "HTTP/1.1 431 ", 13) == 0);
+      simple_archiver_helper_cleanup_c_string(&out_str);
+      CHECK_TRUE(citem.in.size == 0);
+      c_simple_http_output_queue_clear(&citem.out);
+    }
+
+    // The 431 to a HEAD request has no body.
+    {
+      c_simple_http_connection_item_reuse(&citem);
+      char head_raw[C_SIMPLE_HTTP_MAX_REQUEST_SIZE + 2];
+      memset(head_raw, 'a', sizeof(head_raw));
+      memcpy(head_raw, "HEAD / HTTP/1.1\r\nX: ", 20);
+      CHECK_TRUE(c_simple_http_connection_handle_input(
+                   &citem, &ctx, head_raw, sizeof(head_raw))
+                 != 0);
+      out_str = test_internal_output_queue_to_string(&citem.out);
+      CHECK_TRUE(strncmp(out_str, "HTTP/1.1 431 ", 13) == 0);
+      const size_t out_size = strlen(out_str);
+      CHECK_TRUE(out_size > 2 && strcmp(out_str + out_size - 2, "\n\n") == 0);
+      simple_archiver_helper_cleanup_c_string(&out_str);
+      c_simple_http_output_queue_clear(&citem.out);
+    }
+
+    const char *root_close_response =
+      "HTTP/1.1 200 OK\nAllow: GET, HEAD\nConnection: close\n"
+      "Content-Type: text/html\nContent-Length: 11\n\n<p>Root</p>";
+
+    // "Connection: close" closes the connection after the response, and any
+    // following requests are ignored.
+    {
+      c_simple_http_connection_item_reuse(&citem);
+      char close_raw[] = "GET / HTTP/1.1\r\nConnection: close\r\n\r\n"
+                         "GET /b HTTP/1.1\r\n\r\n";
+      CHECK_TRUE(c_simple_http_connection_handle_input(
+                   &citem, &ctx, close_raw, sizeof(close_raw) - 1)
+                 != 0);
+      out_str = test_internal_output_queue_to_string(&citem.out);
+      CHECK_STREQ(out_str, root_close_response);
+      simple_archiver_helper_cleanup_c_string(&out_str);
+      CHECK_FALSE(citem.flags & 0x10);
+      CHECK_TRUE(citem.in.size == 0);
+      c_simple_http_output_queue_clear(&citem.out);
+    }
+
+    // HTTP/1.0 without keep-alive is not kept alive (and is not supported).
+    {
+      c_simple_http_connection_item_reuse(&citem);
+      char http_1_0_raw[] = "GET / HTTP/1.0\r\n\r\n";
+      CHECK_TRUE(c_simple_http_connection_handle_input(
+                   &citem, &ctx, http_1_0_raw, sizeof(http_1_0_raw) - 1)
+                 != 0);
+      out_str = test_internal_output_queue_to_string(&citem.out);
+      CHECK_TRUE(strncmp(out_str, "HTTP/1.1 400 ", 13) == 0);
+      CHECK_TRUE(strstr(out_str, "\nConnection: close\n"));
+      simple_archiver_helper_cleanup_c_string(&out_str);
+      CHECK_FALSE(citem.flags & 0x10);
+      c_simple_http_output_queue_clear(&citem.out);
+    }
+
+    // The last of "--keep-alive-max-requests" requests closes the connection
+    // once its response is sent.
+    {
+      c_simple_http_connection_item_reuse(&citem);
+      args.keep_alive_max_requests = 2;
+      int fds[2];
+      ASSERT_TRUE(
+        socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) == 0);
+      citem.fd = fds[0];
+      char recv_buf[C_SIMPLE_HTTP_RECV_BUF_SIZE];
+      ctx.buf = recv_buf;
+
+      const char *requests = "GET / HTTP/1.1\r\n\r\nGET / HTTP/1.1\r\n\r\n"
+                             "GET /b HTTP/1.1\r\n\r\n";
+      ASSERT_TRUE(write(fds[1], requests, strlen(requests))
+                  == (ssize_t)strlen(requests));
+      CHECK_TRUE(c_simple_http_manage_connections(&citem, &ctx) != 0);
+      CHECK_TRUE((citem.flags & 0x20) != 0);
+      CHECK_FALSE(citem.flags & 0x10);
+      CHECK_TRUE(citem.request_count == 1);
+      CHECK_TRUE(citem.out.size == 0);
+
+      char expected[512];
+      snprintf(expected,
+               sizeof(expected),
+               "%s%s",
+               root_response,
+               root_close_response);
+      char sent[512];
+      ssize_t sent_size = read(fds[1], sent, sizeof(sent) - 1);
+      ASSERT_TRUE(sent_size > 0);
+      sent[sent_size] = 0;
+      CHECK_STREQ(sent, expected);
+
+      close(fds[1]);
+      ctx.buf = NULL;
+      args.keep_alive_max_requests = 100;
+    }
+  }
+
+  // Test that io_uring evicts a peer that stopped reading its response.
+  if (c_simple_http_io_uring_is_supported()) {
+    __attribute__((cleanup(test_internal_cleanup_delete_temporary_file)))
+    const char *test_evict_config_filename =
+      "/tmp/c_simple_http_evict_test.config";
+    // Far larger than the socket's buffers, so the send stays in-flight.
+    const size_t html_size = 1024 * 1024;
+    __attribute__((cleanup(simple_archiver_helper_cleanup_c_string)))
+    char *html = malloc(html_size + 1);
+    ASSERT_TRUE(html);
+    memset(html, 'a', html_size);
+    html[html_size] = 0;
+    FILE *test_file = fopen(test_evict_config_filename, "w");
+    ASSERT_TRUE(test_file);
+    ASSERT_TRUE(fputs("PATH=/\nHTML=", test_file) >= 0);
+    ASSERT_TRUE(fputs(html, test_file) >= 0);
+    ASSERT_TRUE(fputs("\n", test_file) >= 0);
+    fclose(test_file);
+
+    __attribute__((cleanup(c_simple_http_clean_up_parsed_config)))
+    C_SIMPLE_HTTP_ParsedConfig parsed = c_simple_http_parse_config(
+      test_evict_config_filename, "PATH", NULL);
+    ASSERT_TRUE(parsed.paths);
+
+    Args args;
+    memset(&args, 0, sizeof(Args));
+    args.flags = 0x11;
+    args.max_connections = 4;
+    args.listen_backlog = 4;
+    args.keep_alive_max_requests = 100;
+    args.keep_alive_timeout_seconds = 1;
+    args.header_timeout_seconds = 1;
+    args.idle_timeout_seconds = 1;
+    args.drain_timeout_seconds = 30;
+    ConnectionContext ctx;
+    memset(&ctx, 0, sizeof(ConnectionContext));
+    ctx.args = &args;
+    ctx.parsed = &parsed;
+    char recv_buf[C_SIMPLE_HTTP_RECV_BUF_SIZE];
+    ctx.buf = recv_buf;
+
+    C_SIMPLE_HTTP_Listeners listeners;
+    memset(&listeners, 0, sizeof(C_SIMPLE_HTTP_Listeners));
+    ASSERT_TRUE(
+      c_simple_http_listener_parse_addr("unix:/tmp/c_simple_http_evict.sock",
+                                        0,
+                                        &listeners.listeners[0].addr,
+                                        &listeners.listeners[0].addr_len)
+      == 0);
+    listeners.listeners[0].fd = c_simple_http_listener_create(
+      (const struct sockaddr *)&listeners.listeners[0].addr,
+      listeners.listeners[0].addr_len,
+      0,
+      0,
+      &args);
+    ASSERT_TRUE(listeners.listeners[0].fd >= 0);
+    listeners.listeners[0].flags = 3;
+    listeners.count = 1;
+
+    // Connected before the loop runs, so it is accepted before draining
+    // stops accepting.
+    int client_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    ASSERT_TRUE(client_fd >= 0);
+    ASSERT_TRUE(connect(client_fd,
+                        (const struct sockaddr *)&listeners.listeners[0].addr,
+                        listeners.listeners[0].addr_len)
+                == 0);
+    const char *request = "GET / HTTP/1.1\r\n\r\n";
+    ASSERT_TRUE(write(client_fd, request, strlen(request))
+                == (ssize_t)strlen(request));
+
+    C_SIMPLE_HTTP_EventLoop loop;
+    ASSERT_TRUE(c_simple_http_event_loop_init(&loop, &ctx, &listeners, -1, -1)
+                == 0);
+    // The loop only returns early once the connection is gone.
+    C_SIMPLE_HTTP_DRAINING = 1;
+    CHECK_TRUE(c_simple_http_io_uring_run(&loop) == 0);
+    C_SIMPLE_HTTP_DRAINING = 0;
+    CHECK_TRUE(c_simple_http_connection_pool_count(&loop.connections) == 0);
+    // Evicted after the idle timeout, not at the drain deadline.
+    CHECK_FALSE(loop.flags & 0x10);
+
+    c_simple_http_event_loop_cleanup(&loop);
+    c_simple_http_listeners_cleanup(&listeners);
+    close(client_fd);
+  }
+
+  // Test rate limiter.
+  {
+    C_SIMPLE_HTTP_RateLimiter limiter;
+    ASSERT_TRUE(c_simple_http_rate_limiter_init(&limiter, 2, 3) == 0);
+    struct timespec now = {.tv_sec = 100, .tv_nsec = 0};
+    struct in6_addr addr_a;
+    struct in6_addr addr_b;
+    struct in6_addr addr_c;
+    struct in6_addr addr_v4;
+    ASSERT_TRUE(inet_pton(AF_INET6, "2001:db8:0:1::1", &addr_a) == 1);
+    ASSERT_TRUE(inet_pton(AF_INET6, "2001:db8:0:1::2", &addr_b) == 1);
+    ASSERT_TRUE(inet_pton(AF_INET6, "2001:db8:0:2::1", &addr_c) == 1);
+    ASSERT_TRUE(inet_pton(AF_INET6, "::ffff:192.0.2.1", &addr_v4) == 1);
+
+    // The burst, then limited.
+    CHECK_TRUE(c_simple_http_rate_limiter_take(&limiter, &addr_a, &now) == 0);
+    CHECK_TRUE(c_simple_http_rate_limiter_take(&limiter, &addr_a, &now) == 0);
+    CHECK_TRUE(c_simple_http_rate_limiter_take(&limiter, &addr_a, &now) == 0);
+    CHECK_TRUE(c_simple_http_rate_limiter_take(&limiter, &addr_a, &now) != 0);
+    // Same /64.
+    CHECK_TRUE(c_simple_http_rate_limiter_take(&limiter, &addr_b, &now) != 0);
+    // Other /64 and IPv4 clients have their own buckets.
+    CHECK_TRUE(c_simple_http_rate_limiter_take(&limiter, &addr_c, &now) == 0);
+    CHECK_TRUE(c_simple_http_rate_limiter_take(&limiter, &addr_v4, &now) == 0);
+    // Unix socket peers are not limited.
+    CHECK_TRUE(c_simple_http_rate_limiter_take(&limiter, &in6addr_any, &now)
+               == 0);
+
+    // Refilled at 2 per second.
+    now.tv_nsec = 500000000;
+    CHECK_TRUE(c_simple_http_rate_limiter_take(&limiter, &addr_a, &now) == 0);
+    CHECK_TRUE(c_simple_http_rate_limiter_take(&limiter, &addr_a, &now) != 0);
+    // Up to the burst.
+    now.tv_sec += 60;
+    CHECK_TRUE(c_simple_http_rate_limiter_take(&limiter, &addr_a, &now) == 0);
+    CHECK_TRUE(c_simple_http_rate_limiter_take(&limiter, &addr_a, &now) == 0);
+    CHECK_TRUE(c_simple_http_rate_limiter_take(&limiter, &addr_a, &now) == 0);
+    CHECK_TRUE(c_simple_http_rate_limiter_take(&limiter, &addr_a, &now) != 0);
+
+    c_simple_http_rate_limiter_cleanup(&limiter);
+  }
+
+  // Test "--worker-cpus" lists.
+  {
+    CHECK_TRUE(c_simple_http_cpu_list_count("0") == 1);
+    CHECK_TRUE(c_simple_http_cpu_list_count("0,2,4") == 3);
+    CHECK_TRUE(c_simple_http_cpu_list_count("0-1,2-3,7") == 3);
+    CHECK_TRUE(c_simple_http_cpu_list_count("") == 0);
+    CHECK_TRUE(c_simple_http_cpu_list_count("0,") == 0);
+    CHECK_TRUE(c_simple_http_cpu_list_count(",0") == 0);
+    CHECK_TRUE(c_simple_http_cpu_list_count("3-1") == 0);
+    CHECK_TRUE(c_simple_http_cpu_list_count("0-") == 0);
+    CHECK_TRUE(c_simple_http_cpu_list_count("a") == 0);
+    CHECK_TRUE(c_simple_http_cpu_list_count("1 ") == 0);
+    CHECK_TRUE(c_simple_http_cpu_list_count("99999") == 0);
+  }
+
+  // Test listener address parsing.
+  {
+    struct sockaddr_storage addr;
+    socklen_t addr_len;
+
+    ASSERT_TRUE(
+      c_simple_http_listener_parse_addr("unix:/tmp/test.sock",
+                                        80,
+                                        &addr,
+                                        &addr_len) == 0);
+    CHECK_TRUE(addr.ss_family == AF_UNIX);
+    CHECK_STREQ(((struct sockaddr_un *)&addr)->sun_path, "/tmp/test.sock");
+
+    ASSERT_TRUE(
+      c_simple_http_listener_parse_addr("unix:@abstract",
+                                        80,
+                                        &addr,
+                                        &addr_len) == 0);
+    CHECK_TRUE(((struct sockaddr_un *)&addr)->sun_path[0] == 0);
+    CHECK_TRUE(addr_len == offsetof(struct sockaddr_un, sun_path) + 9);
+
+    ASSERT_TRUE(
+      c_simple_http_listener_parse_addr("127.0.0.1:8080",
+                                        80,
+                                        &addr,
+                                        &addr_len) == 0);
+    CHECK_TRUE(addr.ss_family == AF_INET);
+    CHECK_TRUE(addr_len == sizeof(struct sockaddr_in));
+    CHECK_TRUE(ntohs(((struct sockaddr_in *)&addr)->sin_port) == 8080);
+    CHECK_TRUE(ntohl(((struct sockaddr_in *)&addr)->sin_addr.s_addr)
+               == 0x7F000001);
+
+    ASSERT_TRUE(
+      c_simple_http_listener_parse_addr("10.0.0.1", 80, &addr, &addr_len)
+      == 0);
+    CHECK_TRUE(ntohs(((struct sockaddr_in *)&addr)->sin_port) == 80);
+
+    ASSERT_TRUE(
+      c_simple_http_listener_parse_addr("[::1]:443", 80, &addr, &addr_len)
+      == 0);
+    CHECK_TRUE(addr.ss_family == AF_INET6);
+    CHECK_TRUE(ntohs(((struct sockaddr_in6 *)&addr)->sin6_port) == 443);
+    CHECK_TRUE(
+      IN6_IS_ADDR_LOOPBACK(&((struct sockaddr_in6 *)&addr)->sin6_addr));
+
+    ASSERT_TRUE(
+      c_simple_http_listener_parse_addr("[::]", 80, &addr, &addr_len) == 0);
+    CHECK_TRUE(ntohs(((struct sockaddr_in6 *)&addr)->sin6_port) == 80);
+
+    CHECK_FALSE(
+      c_simple_http_listener_parse_addr("unix:", 80, &addr, &addr_len) == 0);
+    CHECK_FALSE(
+      c_simple_http_listener_parse_addr("::1", 80, &addr, &addr_len) == 0);
+    CHECK_FALSE(
+      c_simple_http_listener_parse_addr("[::1]:", 80, &addr, &addr_len) == 0);
+    CHECK_FALSE(
+      c_simple_http_listener_parse_addr("[::1]x", 80, &addr, &addr_len) == 0);
+    CHECK_FALSE(
+      c_simple_http_listener_parse_addr("1.2.3.4:70000",
+                                        80,
+                                        &addr,
+                                        &addr_len) == 0);
+    CHECK_FALSE(
+      c_simple_http_listener_parse_addr("localhost:80",
+                                        80,
+                                        &addr,
+                                        &addr_len) == 0);
+
+    // IPv4 peers are IPv4-mapped.
+    struct sockaddr_in *ipv4_peer = (struct sockaddr_in *)&addr;
+    memset(&addr, 0, sizeof(struct sockaddr_storage));
+    ipv4_peer->sin_family = AF_INET;
+    ipv4_peer->sin_addr.s_addr = htonl(0x7F000001);
+    struct in6_addr mapped;
+    c_simple_http_listener_peer_to_ipv6(&addr, &mapped);
+    CHECK_TRUE(IN6_IS_ADDR_V4MAPPED(&mapped));
+    CHECK_TRUE(mapped.s6_addr[12] == 127 && mapped.s6_addr[15] == 1);
+  }
+
+  // Test listeners using inherited sockets.
+  {
+    Args args;
+    memset(&args, 0, sizeof(Args));
+    args.workers = 1;
+    args.listen_backlog = 4;
+    args.listen_addrs = simple_archiver_list_init();
+    simple_archiver_list_add(args.listen_addrs,
+                             "127.0.0.1:0",
+                             simple_archiver_helper_datastructure_cleanup_nop);
+
+    struct sockaddr_storage addr;
+    socklen_t addr_len;
+    ASSERT_TRUE(
+      c_simple_http_listener_parse_addr("127.0.0.1:0", 0, &addr, &addr_len)
+      == 0);
+    C_SIMPLE_HTTP_Listener inherited_listener;
+    memset(&inherited_listener, 0, sizeof(C_SIMPLE_HTTP_Listener));
+    inherited_listener.fd = c_simple_http_listener_create(
+      (struct sockaddr *)&addr, addr_len, 0, 0, &args);
+    ASSERT_TRUE(inherited_listener.fd >= 0);
+    inherited_listener.flags = 1;
+    inherited_listener.addr_len = sizeof(struct sockaddr_storage);
+    ASSERT_TRUE(getsockname(inherited_listener.fd,
+                            (struct sockaddr *)&inherited_listener.addr,
+                            &inherited_listener.addr_len) == 0);
+
+    C_SIMPLE_HTTP_InheritedListeners inherited;
+    inherited.listeners = malloc(sizeof(C_SIMPLE_HTTP_Listener));
+    inherited.listeners[0] = inherited_listener;
+    inherited.count = 1;
+
+    C_SIMPLE_HTTP_Listeners listeners;
+    ASSERT_TRUE(c_simple_http_listeners_open(&listeners, &inherited, &args)
+                == 0);
+    CHECK_TRUE(listeners.count == 1);
+    CHECK_TRUE(listeners.listeners[0].fd == inherited_listener.fd);
+    CHECK_TRUE(inherited.count == 0);
+
+    c_simple_http_listeners_cleanup(&listeners);
+    c_simple_http_inherited_listeners_cleanup(&inherited);
+    CHECK_FALSE(inherited.listeners);
+    simple_archiver_list_free(&args.listen_addrs);
+  }
+  {
+    char pid_str[32];
+    snprintf(pid_str, sizeof(pid_str), "%lu", (unsigned long)getpid());
+    C_SIMPLE_HTTP_InheritedListeners inherited;
+
+    // Malformed counts are rejected, sockets for other processes ignored.
+    setenv("LISTEN_PID", pid_str, 1);
+    setenv("LISTEN_FDS", "", 1);
+    CHECK_TRUE(c_simple_http_listeners_inherit(&inherited) != 0);
+    CHECK_FALSE(getenv("LISTEN_PID"));
+    CHECK_FALSE(getenv("LISTEN_FDS"));
+    setenv("LISTEN_PID", pid_str, 1);
+    setenv("LISTEN_FDS", "1x", 1);
+    CHECK_TRUE(c_simple_http_listeners_inherit(&inherited) != 0);
+    setenv("LISTEN_PID", pid_str, 1);
+    setenv("LISTEN_FDS", "-1", 1);
+    CHECK_TRUE(c_simple_http_listeners_inherit(&inherited) != 0);
+    setenv("LISTEN_PID", "", 1);
+    setenv("LISTEN_FDS", "1", 1);
+    CHECK_TRUE(c_simple_http_listeners_inherit(&inherited) == 0);
+    CHECK_TRUE(inherited.count == 0);
+    setenv("LISTEN_PID", "1x", 1);
+    setenv("LISTEN_FDS", "1", 1);
+    CHECK_TRUE(c_simple_http_listeners_inherit(&inherited) == 0);
+    CHECK_TRUE(inherited.count == 0);
+
+    // An inherited fd that is not a listening socket is closed.
+    const int saved_fd = dup(3);
+    int pipe_fds[2];
+    ASSERT_TRUE(pipe(pipe_fds) == 0);
+    ASSERT_TRUE(dup2(pipe_fds[0], 3) == 3);
+    setenv("LISTEN_PID", pid_str, 1);
+    setenv("LISTEN_FDS", "1", 1);
+    CHECK_TRUE(c_simple_http_listeners_inherit(&inherited) == 0);
+    CHECK_TRUE(inherited.count == 0);
+    CHECK_TRUE(fcntl(3, F_GETFD) == -1);
+    c_simple_http_inherited_listeners_cleanup(&inherited);
+    if (saved_fd >= 0) {
+      dup2(saved_fd, 3);
+      close(saved_fd);
+    }
+    if (pipe_fds[0] != 3) {
+      close(pipe_fds[0]);
+    }
+    close(pipe_fds[1]);
   }
 
   RETURN()
@@ -0,0 +1,129 @@
+// ISC License
+// 
+// Copyright (c) 2026 Stephen Seo
+// 
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "timer_wheel.h"
+
+// Standard library includes.
+#include <string.h>
+
+// Local includes.
+#include "helpers.h"
+
+/// Returns the tick that "now" is in.
+uint64_t c_simple_http_internal_timer_wheel_tick(
+    const C_SIMPLE_HTTP_TimerWheel *wheel,
+    const struct timespec *now) {
+  int64_t elapsed = c_simple_http_helper_timespec_diff_millis(&wheel->start,
+                                                              now);
+  return elapsed < 0
+    ? 0
+    : (uint64_t)elapsed / C_SIMPLE_HTTP_TIMER_WHEEL_TICK_MILLIS;
+}
+
+void c_simple_http_timer_wheel_init(C_SIMPLE_HTTP_TimerWheel *wheel,
+                                    const struct timespec *now) {
+  memset(wheel, 0, sizeof(C_SIMPLE_HTTP_TimerWheel));
+  wheel->start = *now;
+}
+
+void c_simple_http_timer_wheel_schedule(C_SIMPLE_HTTP_TimerWheel *wheel,
+                                        C_SIMPLE_HTTP_TimerEntry *entry,
+                                        const struct timespec *now,
+                                        int64_t millis) {
+  c_simple_http_timer_cancel(entry);
+
+  // Rounded up so that entries never expire early.
+  uint64_t ticks = millis <= 0
+    ? 0
+    : ((uint64_t)millis + C_SIMPLE_HTTP_TIMER_WHEEL_TICK_MILLIS - 1)
+      / C_SIMPLE_HTTP_TIMER_WHEEL_TICK_MILLIS;
+  entry->expire_tick =
+    c_simple_http_internal_timer_wheel_tick(wheel, now) + ticks;
+  if (entry->expire_tick < wheel->current_tick) {
+    entry->expire_tick = wheel->current_tick;
+  }
+
+  C_SIMPLE_HTTP_TimerEntry **slot =
+    &wheel->slots[entry->expire_tick % C_SIMPLE_HTTP_TIMER_WHEEL_SLOTS];
+  entry->next = *slot;
+  if (entry->next) {
+    entry->next->pprev = &entry->next;
+  }
+  entry->pprev = slot;
+  *slot = entry;
+}
+
+void c_simple_http_timer_cancel(C_SIMPLE_HTTP_TimerEntry *entry) {
+  if (!entry->pprev) {
+    return;
+  }
+  *entry->pprev = entry->next;
+  if (entry->next) {
+    entry->next->pprev = entry->pprev;
+  }
+  entry->next = NULL;
+  entry->pprev = NULL;
+}
+
+int c_simple_http_timer_is_scheduled(const C_SIMPLE_HTTP_TimerEntry *entry) {
+  return entry->pprev ? 1 : 0;
+}
+
+int64_t c_simple_http_timer_wheel_next_timeout(
+    const C_SIMPLE_HTTP_TimerWheel *wheel,
+    const struct timespec *now) {
+  for (uint64_t idx = 0; idx < C_SIMPLE_HTTP_TIMER_WHEEL_SLOTS; ++idx) {
+    uint64_t tick = wheel->current_tick + idx;
+    if (wheel->slots[tick % C_SIMPLE_HTTP_TIMER_WHEEL_SLOTS]) {
+      int64_t remaining =
+        (int64_t)(tick * C_SIMPLE_HTTP_TIMER_WHEEL_TICK_MILLIS)
+        - c_simple_http_helper_timespec_diff_millis(&wheel->start, now);
+      return remaining < 0 ? 0 : remaining;
+    }
+  }
+
+  return -1;
+}
+
+void c_simple_http_timer_wheel_expire(C_SIMPLE_HTTP_TimerWheel *wheel,
+                                      const struct timespec *now,
+                                      C_SIMPLE_HTTP_TimerFn fn,
+                                      void *ud) {
+  const uint64_t now_tick = c_simple_http_internal_timer_wheel_tick(wheel,
+                                                                    now);
+  // Every slot is visited at most once even if many ticks have passed.
+  for (uint64_t tick = wheel->current_tick;
+      tick <= now_tick
+        && tick - wheel->current_tick < C_SIMPLE_HTTP_TIMER_WHEEL_SLOTS;
+      ++tick) {
+    C_SIMPLE_HTTP_TimerEntry *entry =
+      wheel->slots[tick % C_SIMPLE_HTTP_TIMER_WHEEL_SLOTS];
+    while (entry) {
+      C_SIMPLE_HTTP_TimerEntry *next = entry->next;
+      if (entry->expire_tick <= now_tick) {
+        c_simple_http_timer_cancel(entry);
+        fn(entry, ud);
+      }
+      entry = next;
+    }
+  }
+
+  if (now_tick + 1 > wheel->current_tick) {
+    wheel->current_tick = now_tick + 1;
+  }
+}
+
+// vim: et ts=2 sts=2 sw=2
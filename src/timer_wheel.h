@@ -0,0 +1,83 @@
+// ISC License
+// 
+// Copyright (c) 2026 Stephen Seo
+// 
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef SEODISPARATE_COM_C_SIMPLE_HTTP_TIMER_WHEEL_H_
+#define SEODISPARATE_COM_C_SIMPLE_HTTP_TIMER_WHEEL_H_
+
+// Standard library includes.
+#include <stdint.h>
+
+// Linux/Unix includes.
+#include <time.h>
+
+// Local includes.
+#include "constants.h"
+
+/// Embedded in whatever has a timeout. Must be zeroed before first use.
+typedef struct C_SIMPLE_HTTP_TimerEntry {
+  struct C_SIMPLE_HTTP_TimerEntry *next;
+  // Points to the previous entry's "next", or to the slot. Is NULL if not
+  // scheduled.
+  struct C_SIMPLE_HTTP_TimerEntry **pprev;
+  uint64_t expire_tick;
+} C_SIMPLE_HTTP_TimerEntry;
+
+/// Hashed timing wheel. Each slot holds the entries expiring on ticks that
+/// are equal modulo C_SIMPLE_HTTP_TIMER_WHEEL_SLOTS, so scheduling and
+/// cancelling are O(1). Entries scheduled further than a full turn ahead
+/// stay in their slot until their tick is reached.
+/// Entries point into the wheel, so it must not be moved once initialized.
+typedef struct C_SIMPLE_HTTP_TimerWheel {
+  C_SIMPLE_HTTP_TimerEntry *slots[C_SIMPLE_HTTP_TIMER_WHEEL_SLOTS];
+  struct timespec start;
+  // Ticks before this one were already expired.
+  uint64_t current_tick;
+} C_SIMPLE_HTTP_TimerWheel;
+
+typedef void (*C_SIMPLE_HTTP_TimerFn)(C_SIMPLE_HTTP_TimerEntry *entry,
+                                      void *ud);
+
+void c_simple_http_timer_wheel_init(C_SIMPLE_HTTP_TimerWheel *wheel,
+                                    const struct timespec *now);
+
+/// Schedules "entry" to expire "millis" milliseconds after "now". It is
+/// rescheduled if it was already scheduled.
+void c_simple_http_timer_wheel_schedule(C_SIMPLE_HTTP_TimerWheel *wheel,
+                                        C_SIMPLE_HTTP_TimerEntry *entry,
+                                        const struct timespec *now,
+                                        int64_t millis);
+
+/// Does nothing if "entry" is not scheduled.
+void c_simple_http_timer_cancel(C_SIMPLE_HTTP_TimerEntry *entry);
+
+int c_simple_http_timer_is_scheduled(const C_SIMPLE_HTTP_TimerEntry *entry);
+
+/// Returns the milliseconds until the next slot with entries is due, or -1
+/// if nothing is scheduled.
+int64_t c_simple_http_timer_wheel_next_timeout(
+  const C_SIMPLE_HTTP_TimerWheel *wheel,
+  const struct timespec *now);
+
+/// Calls "fn" with each entry that expired by "now". Entries are unscheduled
+/// before "fn" is called, and "fn" may schedule or free them.
+void c_simple_http_timer_wheel_expire(C_SIMPLE_HTTP_TimerWheel *wheel,
+                                      const struct timespec *now,
+                                      C_SIMPLE_HTTP_TimerFn fn,
+                                      void *ud);
+
+#endif
+
+// vim: et ts=2 sts=2 sw=2
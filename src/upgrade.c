@@ -0,0 +1,200 @@
+// ISC License
+// 
+// Copyright (c) 2026 Stephen Seo
+// 
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+// Required for execvpe().
+#define _GNU_SOURCE
+
+#include "upgrade.h"
+
+// Standard library includes.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Linux/Unix includes.
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+
+// Local includes.
+#include "constants.h"
+#include "helpers.h"
+
+extern char **environ;
+
+/// Is async-signal-safe.
+void c_simple_http_internal_upgrade_write_uint(char *buf, unsigned long value) {
+  char digits[24];
+  size_t count = 0;
+  do {
+    digits[count++] = (char)('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+  while (count > 0) {
+    *buf++ = digits[--count];
+  }
+  *buf = 0;
+}
+
+/// Returns zero once a byte was read from "ready_fd".
+int c_simple_http_internal_upgrade_wait_ready(int ready_fd) {
+  struct timespec start;
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  while (1) {
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int64_t remaining = C_SIMPLE_HTTP_UPGRADE_READY_TIMEOUT_MILLIS
+      - c_simple_http_helper_timespec_diff_millis(&start, &now);
+    if (remaining <= 0) {
+      fprintf(stderr, "ERROR New process did not become ready in time!\n");
+      return 1;
+    }
+
+    struct pollfd pfd;
+    pfd.fd = ready_fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    int ret = poll(&pfd, 1, (int)remaining);
+    if (ret < 0 && errno == EINTR) {
+      continue;
+    } else if (ret < 0) {
+      fprintf(stderr, "ERROR Failed to wait on new process! (errno %d)\n",
+              errno);
+      return 1;
+    } else if (ret == 0) {
+      continue;
+    }
+
+    char byte;
+    ssize_t read_ret = read(ready_fd, &byte, 1);
+    if (read_ret == 1) {
+      return 0;
+    } else if (read_ret < 0 && (errno == EINTR || errno == EAGAIN)) {
+      continue;
+    }
+    fprintf(stderr, "ERROR New process exited before becoming ready!\n");
+    return 1;
+  }
+}
+
+int c_simple_http_upgrade_spawn(char **argv,
+                                const int *fds,
+                                uint32_t fd_count) {
+  // Everything the child needs is prepared before fork(), as only
+  // async-signal-safe functions may be called in it.
+  size_t env_count = 0;
+  while (environ[env_count]) {
+    ++env_count;
+  }
+  char **envp = malloc(sizeof(char *) * (env_count + 4));
+  int *tmp_fds = malloc(sizeof(int) * ((size_t)fd_count + 1));
+  if (!envp || !tmp_fds) {
+    free(envp);
+    free(tmp_fds);
+    fprintf(stderr, "ERROR Failed to allocate for new process!\n");
+    return 1;
+  }
+  size_t envp_idx = 0;
+  for (size_t idx = 0; idx < env_count; ++idx) {
+    if (strncmp(environ[idx], "LISTEN_", 7) != 0
+        && strncmp(environ[idx], "C_SIMPLE_HTTP_READY_FD=", 23) != 0) {
+      envp[envp_idx++] = environ[idx];
+    }
+  }
+  char listen_pid_env[40] = "LISTEN_PID=";
+  char listen_fds_env[40] = "LISTEN_FDS=";
+  char ready_fd_env[48] = "C_SIMPLE_HTTP_READY_FD=";
+  c_simple_http_internal_upgrade_write_uint(listen_fds_env + 11, fd_count);
+  c_simple_http_internal_upgrade_write_uint(ready_fd_env + 23,
+                                            3 + (unsigned long)fd_count);
+  envp[envp_idx++] = listen_pid_env;
+  envp[envp_idx++] = listen_fds_env;
+  envp[envp_idx++] = ready_fd_env;
+  envp[envp_idx] = NULL;
+
+  int ready_pipe[2];
+  if (pipe2(ready_pipe, O_CLOEXEC) != 0) {
+    free(envp);
+    free(tmp_fds);
+    fprintf(stderr, "ERROR Failed to create pipe! (errno %d)\n", errno);
+    return 1;
+  }
+
+  pid_t pid = fork();
+  if (pid == 0) {
+    // The fds are first moved above the range they are passed in, as they
+    // may overlap it. dup2() clears FD_CLOEXEC on the passed fds.
+    const int above = 4 + (int)fd_count;
+    for (uint32_t idx = 0; idx < fd_count; ++idx) {
+      tmp_fds[idx] = fcntl(fds[idx], F_DUPFD_CLOEXEC, above);
+    }
+    tmp_fds[fd_count] = fcntl(ready_pipe[1], F_DUPFD_CLOEXEC, above);
+    for (uint32_t idx = 0; idx <= fd_count; ++idx) {
+      if (tmp_fds[idx] < 0 || dup2(tmp_fds[idx], 3 + (int)idx) < 0) {
+        _exit(127);
+      }
+    }
+    c_simple_http_internal_upgrade_write_uint(listen_pid_env + 11,
+                                              (unsigned long)getpid());
+    execvpe(argv[0], argv, envp);
+    _exit(127);
+  }
+
+  free(envp);
+  free(tmp_fds);
+  close(ready_pipe[1]);
+  if (pid < 0) {
+    close(ready_pipe[0]);
+    fprintf(stderr, "ERROR Failed to fork new process! (errno %d)\n", errno);
+    return 1;
+  }
+
+  int ret = c_simple_http_internal_upgrade_wait_ready(ready_pipe[0]);
+  close(ready_pipe[0]);
+  if (ret != 0) {
+    kill(pid, SIGKILL);
+    waitpid(pid, NULL, 0);
+    return 1;
+  }
+
+  printf("New process %ld is ready.\n", (long)pid);
+  return 0;
+}
+
+void c_simple_http_upgrade_notify_ready(void) {
+  const char *ready_fd_str = getenv("C_SIMPLE_HTTP_READY_FD");
+  if (!ready_fd_str) {
+    return;
+  }
+  int ready_fd = atoi(ready_fd_str);
+  unsetenv("C_SIMPLE_HTTP_READY_FD");
+  if (ready_fd < 3) {
+    return;
+  }
+
+  const char byte = 1;
+  ssize_t ret = write(ready_fd, &byte, 1);
+  (void)ret;
+  close(ready_fd);
+}
+
+// vim: et ts=2 sts=2 sw=2
@@ -0,0 +1,41 @@
+// ISC License
+// 
+// Copyright (c) 2026 Stephen Seo
+// 
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef SEODISPARATE_COM_C_SIMPLE_HTTP_UPGRADE_H_
+#define SEODISPARATE_COM_C_SIMPLE_HTTP_UPGRADE_H_
+
+// Standard library includes.
+#include <stdint.h>
+
+/// Starts a new instance of the program with "argv" (the exec'd binary is
+/// looked up with "argv[0]" again, so a replaced binary is used), passing
+/// "fds" as fd 3 onward with "LISTEN_FDS" and "LISTEN_PID" set. Waits up to
+/// C_SIMPLE_HTTP_UPGRADE_READY_TIMEOUT_MILLIS for the new process to call
+/// c_simple_http_upgrade_notify_ready().
+/// Returns zero once the new process is ready. Otherwise the new process is
+/// stopped.
+int c_simple_http_upgrade_spawn(char **argv,
+                                const int *fds,
+                                uint32_t fd_count);
+
+/// Tells the process that started this one with c_simple_http_upgrade_spawn()
+/// that this process is now accepting connections. Does nothing if this
+/// process was not started that way.
+void c_simple_http_upgrade_notify_ready(void);
+
+#endif
+
+// vim: et ts=2 sts=2 sw=2
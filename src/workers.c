@@ -0,0 +1,190 @@
+// ISC License
+// 
+// Copyright (c) 2026 Stephen Seo
+// 
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include "workers.h"
+
+// Standard library includes.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Linux/Unix includes.
+#include <sys/eventfd.h>
+#include <signal.h>
+#include <unistd.h>
+#include <errno.h>
+
+// Local includes.
+#include "cpu_affinity.h"
+#include "event_loop.h"
+#include "globals.h"
+#include "listener.h"
+#include "signal_handling.h"
+
+void *c_simple_http_internal_worker_thread(void *data) {
+  C_SIMPLE_HTTP_Worker *worker = data;
+
+  if (c_simple_http_cpu_pin_worker(worker->ctx.args,
+                                   worker->idx,
+                                   &worker->listeners) != 0) {
+    worker->ret = 1;
+  } else {
+    __attribute__((cleanup(c_simple_http_event_loop_cleanup)))
+    C_SIMPLE_HTTP_EventLoop event_loop;
+    if (c_simple_http_event_loop_init(&event_loop,
+                                      &worker->ctx,
+                                      &worker->listeners,
+                                      -1,
+                                      worker->wakeup_fd) != 0) {
+      worker->ret = 1;
+    } else {
+      event_loop.flags |= 2;
+      worker->ret = c_simple_http_event_loop_run(&event_loop);
+    }
+  }
+
+  if (worker->ret != 0) {
+    // Stop the whole server, the main thread will join this worker.
+    C_SIMPLE_HTTP_KEEP_RUNNING = 0;
+    C_SIMPLE_HTTP_signal_wakeup();
+  }
+
+  return NULL;
+}
+
+int c_simple_http_workers_start(C_SIMPLE_HTTP_Workers *workers,
+                                const ConnectionContext *ctx,
+                                const C_SIMPLE_HTTP_Listeners *listeners,
+                                C_SIMPLE_HTTP_InheritedListeners *inherited,
+                                uint32_t count) {
+  memset(workers, 0, sizeof(C_SIMPLE_HTTP_Workers));
+  if (count == 0) {
+    return 0;
+  }
+
+  workers->workers = malloc(sizeof(C_SIMPLE_HTTP_Worker) * count);
+  if (!workers->workers) {
+    fprintf(stderr, "ERROR Failed to allocate workers!\n");
+    return 1;
+  }
+  for (uint32_t idx = 0; idx < count; ++idx) {
+    C_SIMPLE_HTTP_Worker *worker = &workers->workers[idx];
+    memset(worker, 0, sizeof(C_SIMPLE_HTTP_Worker));
+    worker->idx = idx + 1;
+    worker->wakeup_fd = -1;
+  }
+  workers->count = count;
+
+  // Signals are only handled by the main thread, so worker threads are
+  // started with all signals blocked.
+  sigset_t all_signals;
+  sigset_t prev_signals;
+  sigfillset(&all_signals);
+  pthread_sigmask(SIG_SETMASK, &all_signals, &prev_signals);
+
+  int ret = 0;
+  for (uint32_t idx = 0; idx < count; ++idx) {
+    C_SIMPLE_HTTP_Worker *worker = &workers->workers[idx];
+    worker->ctx = *ctx;
+    worker->ctx.buf = worker->recv_buf;
+
+    if (c_simple_http_listeners_open_for_worker(&worker->listeners,
+                                                listeners,
+                                                inherited,
+                                                ctx->args) != 0) {
+      ret = 1;
+      break;
+    }
+
+    worker->wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (worker->wakeup_fd < 0) {
+      fprintf(stderr,
+              "ERROR Failed to create eventfd for worker! (errno %d)\n",
+              errno);
+      ret = 1;
+      break;
+    }
+
+    int create_ret = pthread_create(&worker->thread,
+                                    NULL,
+                                    c_simple_http_internal_worker_thread,
+                                    worker);
+    if (create_ret != 0) {
+      fprintf(stderr,
+              "ERROR Failed to start worker thread! (error %d)\n",
+              create_ret);
+      ret = 1;
+      break;
+    }
+    worker->flags |= 1;
+  }
+
+  pthread_sigmask(SIG_SETMASK, &prev_signals, NULL);
+  return ret;
+}
+
+void c_simple_http_workers_wakeup(const C_SIMPLE_HTTP_Workers *workers) {
+  for (uint32_t idx = 0; idx < workers->count; ++idx) {
+    const C_SIMPLE_HTTP_Worker *worker = &workers->workers[idx];
+    if ((worker->flags & 1) != 0) {
+      uint64_t value = 1;
+      ssize_t write_ret = write(worker->wakeup_fd, &value, sizeof(uint64_t));
+      (void)write_ret;
+    }
+  }
+}
+
+int c_simple_http_workers_stop(C_SIMPLE_HTTP_Workers *workers) {
+  if (!C_SIMPLE_HTTP_DRAINING) {
+    C_SIMPLE_HTTP_KEEP_RUNNING = 0;
+  }
+  c_simple_http_workers_wakeup(workers);
+
+  int ret = 0;
+  for (uint32_t idx = 0; idx < workers->count; ++idx) {
+    C_SIMPLE_HTTP_Worker *worker = &workers->workers[idx];
+    if ((worker->flags & 1) == 0) {
+      continue;
+    }
+
+    pthread_join(worker->thread, NULL);
+    worker->flags &= ~(uint32_t)1;
+    if (ret == 0) {
+      ret = worker->ret;
+    }
+  }
+
+  return ret;
+}
+
+void c_simple_http_workers_cleanup(C_SIMPLE_HTTP_Workers *workers) {
+  if (workers && workers->workers) {
+    c_simple_http_workers_stop(workers);
+    for (uint32_t idx = 0; idx < workers->count; ++idx) {
+      C_SIMPLE_HTTP_Worker *worker = &workers->workers[idx];
+      c_simple_http_listeners_cleanup(&worker->listeners);
+      if (worker->wakeup_fd >= 0) {
+        close(worker->wakeup_fd);
+        worker->wakeup_fd = -1;
+      }
+    }
+    free(workers->workers);
+    workers->workers = NULL;
+    workers->count = 0;
+  }
+}
+
+// vim: et ts=2 sts=2 sw=2
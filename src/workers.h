@@ -0,0 +1,76 @@
+// ISC License
+// 
+// Copyright (c) 2026 Stephen Seo
+// 
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR
+// OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef SEODISPARATE_COM_C_SIMPLE_HTTP_WORKERS_H_
+#define SEODISPARATE_COM_C_SIMPLE_HTTP_WORKERS_H_
+
+// Standard library includes.
+#include <stdint.h>
+
+// Linux/Unix includes.
+#include <pthread.h>
+
+// Local includes.
+#include "constants.h"
+#include "helpers.h"
+#include "listener.h"
+
+typedef struct C_SIMPLE_HTTP_Worker {
+  pthread_t thread;
+  // The main thread's event loop is worker 0, so this starts at 1.
+  uint32_t idx;
+  C_SIMPLE_HTTP_Listeners listeners;
+  int wakeup_fd;
+  // xxxx xxx1 - thread was started.
+  uint32_t flags;
+  // Exit code of the worker's event loop.
+  int ret;
+  ConnectionContext ctx;
+  char recv_buf[C_SIMPLE_HTTP_RECV_BUF_SIZE];
+} C_SIMPLE_HTTP_Worker;
+
+typedef struct C_SIMPLE_HTTP_Workers {
+  C_SIMPLE_HTTP_Worker *workers;
+  uint32_t count;
+} C_SIMPLE_HTTP_Workers;
+
+/// Starts "count" worker threads, each running its own event loop with its
+/// own SO_REUSEPORT listeners on the addresses of "listeners" (unix sockets
+/// are shared), using matching "inherited" sockets first (may be NULL). "ctx"
+/// is copied for each worker, and its "args" and "parsed" are shared
+/// read-only (guarded by "config_lock"). Config reloading is left to the main
+/// thread's event loop.
+/// Returns zero on success.
+int c_simple_http_workers_start(C_SIMPLE_HTTP_Workers *workers,
+                                const ConnectionContext *ctx,
+                                const C_SIMPLE_HTTP_Listeners *listeners,
+                                C_SIMPLE_HTTP_InheritedListeners *inherited,
+                                uint32_t count);
+
+/// Wakes up all started worker threads' event loops.
+void c_simple_http_workers_wakeup(const C_SIMPLE_HTTP_Workers *workers);
+
+/// Stops and joins all started worker threads. If C_SIMPLE_HTTP_DRAINING is
+/// set, the workers are left to finish their connections first.
+/// Returns the first non-zero exit code of the workers, or zero.
+int c_simple_http_workers_stop(C_SIMPLE_HTTP_Workers *workers);
+
+/// Stops the workers if necessary and frees them.
+void c_simple_http_workers_cleanup(C_SIMPLE_HTTP_Workers *workers);
+
+#endif
+
+// vim: et ts=2 sts=2 sw=2